@@ -0,0 +1,283 @@
+/*
+
+  almanac_grid.c
+
+  Times of a solar event for one day on a latitude grid, with cubic
+  interpolation in latitude and the exact solver as fallback.
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015-2016 Fabrice Ferino
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+*/
+
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "almanac_grid.h"
+
+/* cubic of one cell: time = c[0] + u (c[1] + u (c[2] + u c[3])),
+   u = (latitude - cell latitude) * scale in [0, 1];
+   c[0] is NaN when the cell is answered by the exact solver */
+typedef struct AlmanacCell
+{
+    double latitude;
+    double scale;
+    double c[4];
+} AlmanacCell;
+
+struct AlmanacGrid
+{
+    double jd;
+    int rise;
+    double angle;
+    SolarPrecision precision;
+
+    double minLatitude;
+    double maxLatitude;
+    double bucketScale;     /* buckets per degree */
+    int numBuckets;
+    int numCells;
+
+    AlmanacCell* cells;
+    double* errorBound;     /* minutes, per cell */
+    int* bucketCell;        /* first cell overlapping each bucket */
+};
+
+/* u at which the cell error is sampled against the exact solution, and
+   margin applied to the largest sampled error for the points in between */
+static const double kErrorSamples[] = { 0.125, 0.25, 0.5, 0.75, 0.875 };
+#define ERROR_MARGIN (1.5)
+
+#define MAX_BUCKETS_PER_CELL (4.0)
+
+static int CompareDoubles(const void* a, const void* b)
+{
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+/* coefficients in u of the cubic through (u[k], t[k]), k = 0..3,
+   from the Newton divided differences */
+static void FitCubic(const double u[4], const double t[4], double c[4])
+{
+    double d[4] = { t[0], t[1], t[2], t[3] };
+    int level, k, j;
+
+    for (level = 1; level < 4; ++level)
+    {
+        for (k = 3; k >= level; --k)
+        {
+            d[k] = (d[k] - d[k - 1]) / (u[k] - u[k - level]);
+        }
+    }
+
+    c[0] = d[3];
+    c[1] = c[2] = c[3] = 0.0;
+    for (k = 2; k >= 0; --k)
+    {
+        /* c = c * (u - u[k]) + d[k] */
+        for (j = 3; j > 0; --j)
+        {
+            c[j] = c[j - 1] - u[k] * c[j];
+        }
+        c[0] = d[k] - u[k] * c[0];
+    }
+}
+
+static double EvaluateCell(const AlmanacCell* cell, double latitude)
+{
+    double u = (latitude - cell->latitude) * cell->scale;
+    return cell->c[0] + u * (cell->c[1] + u * (cell->c[2] + u * cell->c[3]));
+}
+
+AlmanacGrid* AlmanacGridCreate( double jd, int rise, double angle,
+                                const double* latitudes, int numLatitudes,
+                                double toleranceMinutes, SolarPrecision precision)
+{
+    /* the bucket count below must fit an int */
+    if (numLatitudes < 4 || numLatitudes > INT_MAX / (int) MAX_BUCKETS_PER_CELL)
+    {
+        return NULL;
+    }
+
+    double* sorted = malloc(sizeof(double) * numLatitudes);
+    double* times = malloc(sizeof(double) * numLatitudes);
+    int i, k;
+
+    if (NULL == sorted || NULL == times)
+    {
+        free(sorted);
+        free(times);
+        return NULL;
+    }
+    for (i = 0; i < numLatitudes; ++i)
+    {
+        sorted[i] = latitudes[i];
+    }
+    qsort(sorted, numLatitudes, sizeof(double), CompareDoubles);
+
+    double minSpacing = INFINITY;
+    for (i = 1; i < numLatitudes; ++i)
+    {
+        minSpacing = fmin(minSpacing, sorted[i] - sorted[i - 1]);
+    }
+    if (!(minSpacing > 0.0) || !isfinite(sorted[0]) || !isfinite(sorted[numLatitudes - 1]))
+    {
+        free(sorted);
+        free(times);
+        return NULL;
+    }
+
+    /* buckets of half the smallest cell, so that a bucket overlaps at most
+       two cells, but no more than MAX_BUCKETS_PER_CELL per cell: with very
+       uneven spacing a bucket may overlap more cells, stepped through */
+    int numCells = numLatitudes - 1;
+    double range = sorted[numCells] - sorted[0];
+    double bucketScale = fmin(2.0 / minSpacing, MAX_BUCKETS_PER_CELL * numCells / range);
+    int numBuckets = 1 + (int) fmin(range * bucketScale, MAX_BUCKETS_PER_CELL * numCells);
+
+    /* one block: grid, cells, error bounds, buckets */
+    AlmanacGrid* grid = malloc(sizeof(AlmanacGrid) +
+                               (size_t) numCells * (sizeof(AlmanacCell) + sizeof(double)) +
+                               (size_t) numBuckets * sizeof(int));
+    if (NULL == grid)
+    {
+        free(sorted);
+        free(times);
+        return NULL;
+    }
+    grid->jd = jd;
+    grid->rise = rise;
+    grid->angle = angle;
+    grid->precision = precision;
+    grid->minLatitude = sorted[0];
+    grid->maxLatitude = sorted[numCells];
+    grid->bucketScale = bucketScale;
+    grid->numBuckets = numBuckets;
+    grid->numCells = numCells;
+    grid->cells = (AlmanacCell*) (grid + 1);
+    grid->errorBound = (double*) (grid->cells + numCells);
+    grid->bucketCell = (int*) (grid->errorBound + numCells);
+
+    for (i = 0; i < numLatitudes; ++i)
+    {
+        times[i] = UTCForSolarAngleEx( rise, jd, sorted[i], angle, precision);
+    }
+
+    for (i = 0; i < numCells; ++i)
+    {
+        AlmanacCell* cell = grid->cells + i;
+        int first = (i == 0) ? 0 : ((i + 3 > numCells) ? numCells - 3 : i - 1);
+        double u[4], t[4];
+        int usable = 1;
+
+        cell->latitude = sorted[i];
+        cell->scale = 1.0 / (sorted[i + 1] - sorted[i]);
+        for (k = 0; k < 4; ++k)
+        {
+            u[k] = (sorted[first + k] - sorted[i]) * cell->scale;
+            t[k] = times[first + k];
+            usable = usable && !isnan(t[k]);
+        }
+
+        double error = 0.0;
+        if (usable)
+        {
+            FitCubic( u, t, cell->c);
+            for (k = 0; k < (int) (sizeof(kErrorSamples) / sizeof(kErrorSamples[0])); ++k)
+            {
+                double latitude = sorted[i] + kErrorSamples[k] / cell->scale;
+                double exact = UTCForSolarAngleEx( rise, jd, latitude, angle, precision);
+                error = fmax(error, fabs(EvaluateCell( cell, latitude) - exact));
+                usable = usable && !isnan(exact);
+            }
+            error *= ERROR_MARGIN;
+            usable = usable && error <= toleranceMinutes;
+        }
+        if (!usable)
+        {
+            cell->c[0] = NAN;
+            error = 0.0;
+        }
+        grid->errorBound[i] = error;
+    }
+
+    for (i = 0, k = 0; i < numBuckets; ++i)
+    {
+        double latitude = sorted[0] + i / bucketScale;
+        while (k + 1 < numCells && sorted[k + 1] <= latitude)
+        {
+            ++k;
+        }
+        grid->bucketCell[i] = k;
+    }
+
+    free(sorted);
+    free(times);
+    return grid;
+}
+
+void AlmanacGridDestroy( AlmanacGrid* grid)
+{
+    free(grid);
+}
+
+/* cell holding latitude, -1 outside of the grid */
+static int AlmanacGridCell( const AlmanacGrid* grid, double latitude)
+{
+    if (!(latitude >= grid->minLatitude && latitude <= grid->maxLatitude))
+    {
+        return -1;
+    }
+    int bucket = (int) ((latitude - grid->minLatitude) * grid->bucketScale);
+    if (bucket >= grid->numBuckets)
+    {
+        bucket = grid->numBuckets - 1;
+    }
+    int cell = grid->bucketCell[bucket];
+    while (cell + 1 < grid->numCells && latitude >= grid->cells[cell + 1].latitude)
+    {
+        ++cell;
+    }
+    return cell;
+}
+
+double AlmanacGridUTC( const AlmanacGrid* grid, double latitude)
+{
+    int cell = AlmanacGridCell( grid, latitude);
+
+    if (cell >= 0 && !isnan(grid->cells[cell].c[0]))
+    {
+        return EvaluateCell( grid->cells + cell, latitude);
+    }
+    return UTCForSolarAngleEx( grid->rise, grid->jd, latitude, grid->angle,
+                               grid->precision);
+}
+
+double AlmanacGridErrorBound( const AlmanacGrid* grid, double latitude)
+{
+    int cell = AlmanacGridCell( grid, latitude);
+
+    return (cell >= 0) ? grid->errorBound[cell] : 0.0;
+}
@@ -0,0 +1,66 @@
+/*
+ almanac_grid.h
+
+ Times of a solar event for one day on a latitude grid, interpolated to
+ any latitude in between the way the Nautical Almanac tables are used.
+
+ The MIT License (MIT)
+
+Copyright (c) 2015-2016 Fabrice Ferino
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#ifndef ALMANAC_GRID_HEADER
+#define ALMANAC_GRID_HEADER
+
+#include "sunrise_sunset.h"
+
+/*
+ AlmanacGridCreate computes UTCForSolarAngleEx(rise, jd, latitude, angle,
+ precision) at each of the latitudes (any order, at least 4, distinct)
+ and fits, in each cell between two consecutive latitudes, the cubic
+ through the four nearest grid points.
+
+ The error of each cell is estimated against the exact solution at the
+ quarter points. Cells above toleranceMinutes, cells next to a latitude
+ without the event (polar day or night) and latitudes outside the grid
+ are answered by the exact solver.
+
+ AlmanacGridUTC returns minutes after 0h UT, like UTCForSolarAngle; on
+ interpolated cells it costs one table lookup and three multiply-adds
+ (the lookup table holds at most 4 entries per cell, so with very uneven
+ spacing a lookup may also step over a few cells).
+ AlmanacGridErrorBound returns the estimated error of the cell holding
+ latitude, in minutes, 0 where the exact solver is used.
+
+ AlmanacGridCreate returns NULL if the latitudes are unusable or memory
+ is exhausted.
+*/
+typedef struct AlmanacGrid AlmanacGrid;
+
+AlmanacGrid* AlmanacGridCreate(double jd, int rise, double angle,
+                               const double* latitudes, int numLatitudes,
+                               double toleranceMinutes, SolarPrecision precision);
+void AlmanacGridDestroy(AlmanacGrid* grid);
+double AlmanacGridUTC(const AlmanacGrid* grid, double latitude);
+double AlmanacGridErrorBound(const AlmanacGrid* grid, double latitude);
+
+
+#endif
@@ -32,8 +32,11 @@
 #include <stdio.h>
 #include <math.h>
 #include <string.h>
+#include <time.h>
 
 #include "sunrise_sunset.h"
+#include "almanac_grid.h"
+#include "solar_job.h"
 
 /* struct and data used in the JulianDayTest */
 typedef struct JulianDayTestInfo
@@ -63,12 +66,6 @@ JulianDayTestInfo gJulianDayTestInfo[] =
 };
 
 
-typedef struct HourMinute
-{
-    int hour;
-    int minute;
-} HourMinute;
-
 /* latitudes used in the Nautical Almanac */
 const double kLatitudes[] =
 {
@@ -105,24 +102,7 @@ const double kLatitudes[] =
     -60.0
 };
 
-const int kNumLatitudes = sizeof(kLatitudes) / sizeof(kLatitudes[0]);
-
-/* struct used in SunPosition test */
-typedef struct SunPositionTest
-{
-    int y;
-    int m;
-    double dfrac;
-
-    HourMinute nauticalRise[kNumLatitudes];
-    HourMinute civilRise[kNumLatitudes];
-    HourMinute sunRise[kNumLatitudes];
-    HourMinute sunSet[kNumLatitudes];
-    HourMinute civilSet[kNumLatitudes];
-    HourMinute nauticalSet[kNumLatitudes];
-
-} SunPositionTest;
-
+#define kNumLatitudes ((int) (sizeof(kLatitudes) / sizeof(kLatitudes[0])))
 
 int JulianDayTests()
 {
@@ -192,6 +172,58 @@ int GeometricMeanAnomalySunTest()
 }
 
 
+/* Meeus, example 25.b: 1992 October 13.0 TD */
+int VSOP87Test()
+{
+    double centuryTime = JulianCenturyFromJulianDay(2448908.5);
+    double l = HeliocentricLongitudeEarth(centuryTime);
+    double r = RadiusVectorEarth(centuryTime);
+
+    /* L = 19.907372 deg, R = 0.99760775 AU */
+    return (round(l * 1000000.0) == 19907372.0 &&
+            round(r * 100000000.0) == 99760775.0) ? 0 : 1;
+}
+
+/* Meeus, example 22.a: 1987 April 10, 0h TD */
+int NutationTest()
+{
+    double centuryTime = JulianCenturyFromJulianDay(JulianDayEx(1987, 4, 10.0));
+    double deltaPsi, deltaEpsilon;
+
+    Nutation(centuryTime, &deltaPsi, &deltaEpsilon);
+    double epsilon = MeanObliquityEclipticLaskar(centuryTime) + deltaEpsilon;
+
+    int degrees, minutes;
+    double seconds;
+
+    D2DMS(epsilon, &degrees, &minutes, &seconds);
+
+    /* -3.788", +9.443", 23 26' 36.850" */
+    return (round(deltaPsi * 3600000.0) == -3788.0 &&
+            round(deltaEpsilon * 3600000.0) == 9443.0 &&
+            degrees == 23 && minutes == 26 && seconds == 36.849)? 0 : 1;
+}
+
+/* Meeus, examples 28.a and 28.b: 1992 October 13.0 TD, E = 13m42.6s */
+int EquationOfTimeTest()
+{
+    double centuryTime = JulianCenturyFromJulianDay(2448908.5);
+    int retVal = 0;
+    SolarPrecision precision;
+
+    for (precision = kSolarPrecisionFast; precision <= kSolarPrecisionHigh; ++precision)
+    {
+        double e = EquationOfTimeEx(centuryTime, precision);
+        if (fabs(e * 60.0 - (13.0 * 60.0 + 42.6)) > 0.1)
+        {
+            printf("equation of time, precision %d: %lf\n", precision, e);
+            ++retVal;
+        }
+    }
+    return retVal;
+}
+
+
 void FormatMinutes( double minutesd, char s[/*6*/])
 {
     int minutes, hh, mm;
@@ -208,6 +240,132 @@ void FormatMinutes( double minutesd, char s[/*6*/])
 
 typedef char TimeString[6];
 
+/* interpolation on the almanac latitudes within the cell bounds,
+   exact on the grid and outside of it */
+int AlmanacGridTest()
+{
+    double jd = JulianDayEx(1994, 5, 8.0);
+    int retVal = 0;
+    int rise;
+
+    for (rise = 0; rise <= 1; ++rise)
+    {
+        AlmanacGrid* grid = AlmanacGridCreate(jd, rise, kRiseOrSet, kLatitudes, kNumLatitudes,
+                                              0.1, kSolarPrecisionMeeus);
+        double latitude;
+        int i;
+
+        if (NULL == grid)
+        {
+            return 1;
+        }
+        for (i = 0; i < kNumLatitudes; ++i)
+        {
+            double exact = UTCForSolarAngle(rise, jd, kLatitudes[i], kRiseOrSet);
+            double value = AlmanacGridUTC(grid, kLatitudes[i]);
+            if (!(fabs(value - exact) < 1.0e-9) && !(isnan(value) && isnan(exact)))
+            {
+                ++retVal;
+            }
+        }
+        for (latitude = -65.0; latitude <= 75.0; latitude += 0.25)
+        {
+            double exact = UTCForSolarAngle(rise, jd, latitude, kRiseOrSet);
+            double value = AlmanacGridUTC(grid, latitude);
+            double bound = AlmanacGridErrorBound(grid, latitude);
+            if (isnan(exact) != isnan(value) || bound > 0.1 ||
+                fabs(value - exact) > bound + 1.0e-9)
+            {
+                printf("almanac grid, latitude %lf: %lf instead of %lf (bound %lf)\n",
+                       latitude, value, exact, bound);
+                ++retVal;
+            }
+        }
+        AlmanacGridDestroy(grid);
+    }
+
+    /* very uneven spacing: bounded bucket table, cells still found */
+    {
+        const double uneven[] = { -60.0, 0.0, 1.0e-12, 60.0, 70.0 };
+        const double queries[] = { -60.0, -30.0, 0.0, 0.5e-12, 1.0e-12, 30.0, 65.0, 70.0 };
+        AlmanacGrid* grid = AlmanacGridCreate(jd, 1, kRiseOrSet, uneven, 5, 1.0e9,
+                                              kSolarPrecisionMeeus);
+        int i;
+
+        if (NULL == grid)
+        {
+            return retVal + 1;
+        }
+        for (i = 0; i < (int) (sizeof(queries) / sizeof(queries[0])); ++i)
+        {
+            double exact = UTCForSolarAngle(1, jd, queries[i], kRiseOrSet);
+            double value = AlmanacGridUTC(grid, queries[i]);
+            double bound = AlmanacGridErrorBound(grid, queries[i]);
+            if (fabs(value - exact) > bound + 1.0e-6)
+            {
+                printf("uneven almanac grid, latitude %lg: %lf instead of %lf (bound %lf)\n",
+                       queries[i], value, exact, bound);
+                ++retVal;
+            }
+        }
+        AlmanacGridDestroy(grid);
+    }
+    return retVal;
+}
+
+/* the six events of the Nautical Almanac, in the order of SunRiseTest */
+static const SolarEvent kAlmanacEvents[] =
+{
+    { 1, 102.0 }, { 1, 96.0 }, { 1, 90.833 },
+    { 0, 90.833 }, { 0, 96.0 }, { 0, 102.0 }
+};
+
+#define kNumAlmanacEvents ((int) (sizeof(kAlmanacEvents) / sizeof(kAlmanacEvents[0])))
+
+/* same results as UTCForSolarAngleEx, on several threads */
+int SolarTableJobTest(int firstYear, SolarPrecision precision)
+{
+    SolarTableJob job = { firstYear, 2, kLatitudes, kNumLatitudes,
+                          kAlmanacEvents, kNumAlmanacEvents, precision, 3, 1 };
+    SolarArena arena;
+    double small[16];
+    int retVal = 0;
+    int day, l, e;
+
+    SolarArenaInit(&arena, small, sizeof(small));
+    if (0 == SolarTableJobRun(&job, &arena) || 0 != arena.used)
+    {
+        ++retVal; /* arena too small, left unchanged */
+    }
+
+    if (0 != SolarArenaCreate(&arena, SolarTableJobArenaSize(&job)) ||
+        0 != SolarTableJobRun(&job, &arena) ||
+        job.numDays != 730 || job.numBlocks != 3)
+    {
+        SolarArenaDestroy(&arena);
+        return retVal + 1;
+    }
+    for (day = 0; day < job.numDays; ++day)
+    {
+        for (l = 0; l < kNumLatitudes; ++l)
+        {
+            for (e = 0; e < kNumAlmanacEvents; ++e)
+            {
+                double expected = UTCForSolarAngleEx(kAlmanacEvents[e].rise,
+                                                     job.firstJulianDay + day, kLatitudes[l],
+                                                     kAlmanacEvents[e].angle, job.precision);
+                double value = SolarTableJobTime(&job, day, l, e);
+                if (value != expected && !(isnan(value) && isnan(expected)))
+                {
+                    ++retVal;
+                }
+            }
+        }
+    }
+    SolarArenaDestroy(&arena);
+    return retVal;
+}
+
 int SunRiseTest(double jd)
 {
     int i;
@@ -266,6 +424,137 @@ int SunRiseTests()
     return 0;
 }
 
+/* timing and maximum difference to the high precision tier of each tier,
+   over 1900-2100 and the latitudes of the Nautical Almanac */
+int BenchmarkTiers()
+{
+    const char* names[] = { "fast", "meeus", "high" };
+    const double jdStart = JulianDayEx(1900, 1, 1.0);
+    const double jdEnd = JulianDayEx(2100, 1, 1.0);
+    const double step = 3.1; /* days, not commensurate with the year */
+    SolarPrecision precision;
+
+    printf("tier  | ns/decl | ns/eot | ns/rise | decl err \" | eot err s | rise err s\n");
+
+    for (precision = kSolarPrecisionFast; precision <= kSolarPrecisionHigh; ++precision)
+    {
+        double jd, maxDecl = 0.0, maxEot = 0.0, maxRise = 0.0;
+        volatile double sink = 0.0;
+        long count = 0, riseCount = 0;
+        int i;
+
+        clock_t start = clock();
+        for (jd = jdStart; jd < jdEnd; jd += step, ++count)
+        {
+            sink += SunDeclinationRadEx(JulianCenturyFromJulianDay(jd), precision);
+        }
+        double declNs = 1.0e9 * (clock() - start) / CLOCKS_PER_SEC / count;
+
+        start = clock();
+        for (jd = jdStart; jd < jdEnd; jd += step)
+        {
+            sink += EquationOfTimeEx(JulianCenturyFromJulianDay(jd), precision);
+        }
+        double eotNs = 1.0e9 * (clock() - start) / CLOCKS_PER_SEC / count;
+
+        start = clock();
+        for (jd = jdStart; jd < jdEnd; jd += 10.0 * step)
+        {
+            for (i = 0; i < kNumLatitudes; ++i, ++riseCount)
+            {
+                sink += UTCForSolarAngleEx(1, jd, kLatitudes[i], kRiseOrSet, precision);
+            }
+        }
+        double riseNs = 1.0e9 * (clock() - start) / CLOCKS_PER_SEC / riseCount;
+
+        for (jd = jdStart; jd < jdEnd; jd += step)
+        {
+            double centuryTime = JulianCenturyFromJulianDay(jd);
+            double d = SunDeclinationRadEx(centuryTime, precision) -
+                SunDeclinationRadEx(centuryTime, kSolarPrecisionHigh);
+            double e = EquationOfTimeEx(centuryTime, precision) -
+                EquationOfTimeEx(centuryTime, kSolarPrecisionHigh);
+            maxDecl = fmax(maxDecl, fabs(d) * 3600.0 * 180.0 / M_PI);
+            maxEot = fmax(maxEot, fabs(e) * 60.0);
+        }
+        for (jd = jdStart; jd < jdEnd; jd += 10.0 * step)
+        {
+            /* up to 60 deg, beyond the rise time is ill-conditioned */
+            for (i = 6; i < kNumLatitudes; ++i)
+            {
+                double r = UTCForSolarAngleEx(1, jd, kLatitudes[i], kRiseOrSet, precision) -
+                    UTCForSolarAngleEx(1, jd, kLatitudes[i], kRiseOrSet, kSolarPrecisionHigh);
+                if (!isnan(r))
+                {
+                    maxRise = fmax(maxRise, fabs(r) * 60.0);
+                }
+            }
+        }
+
+        printf("%-5s | %7.0lf | %6.0lf | %7.0lf | %10.2lf | %9.2lf | %10.2lf\n",
+               names[precision], declNs, eotNs, riseNs, maxDecl, maxEot, maxRise);
+    }
+    return 0;
+}
+
+/* setup and query cost of the latitude grid on the almanac latitudes */
+int BenchmarkAlmanacGrid()
+{
+    const double jd = JulianDayEx(1994, 5, 8.0);
+    const int numQueries = 1000000;
+    volatile double sink = 0.0;
+    double latitude = -55.0;
+    int i;
+
+    clock_t start = clock();
+    AlmanacGrid* grid = AlmanacGridCreate(jd, 1, kRiseOrSet, kLatitudes, kNumLatitudes,
+                                          0.05, kSolarPrecisionMeeus);
+    double setupUs = 1.0e6 * (clock() - start) / CLOCKS_PER_SEC;
+    if (NULL == grid)
+    {
+        return 1;
+    }
+
+    start = clock();
+    for (i = 0; i < numQueries; ++i)
+    {
+        sink += AlmanacGridUTC(grid, latitude);
+        latitude += 0.000117;
+    }
+    double queryNs = 1.0e9 * (clock() - start) / CLOCKS_PER_SEC / numQueries;
+
+    printf("\nalmanac grid: %.0lf us per day and event, %.1lf ns per query\n",
+           setupUs, queryNs);
+    AlmanacGridDestroy(grid);
+    return 0;
+}
+
+/* 20 years of the almanac events at the almanac latitudes */
+int BenchmarkTableJob()
+{
+    SolarTableJob job = { 1990, 20, kLatitudes, kNumLatitudes,
+                          kAlmanacEvents, kNumAlmanacEvents, kSolarPrecisionMeeus, 0, 1 };
+    SolarArena arena;
+    size_t size = SolarTableJobArenaSize(&job);
+
+    if (0 != SolarArenaCreate(&arena, size) || 0 != SolarTableJobRun(&job, &arena))
+    {
+        SolarArenaDestroy(&arena);
+        return 1;
+    }
+
+    double events = (double) job.numDays * kNumLatitudes * kNumAlmanacEvents;
+    printf("\ntable job: %.0lf events on %d threads, arena %.1lf MB, %.3lf s, %.0lf ns per event\n"
+           "           process peak RSS %ld kB before, %ld kB after, "
+           "%ld minor and %ld major page faults\n",
+           events, job.numBlocks, size / 1048576.0, job.seconds,
+           1.0e9 * job.seconds / events,
+           job.peakResidentKilobytesBefore, job.peakResidentKilobytes,
+           job.minorFaults, job.majorFaults);
+    SolarArenaDestroy(&arena);
+    return 0;
+}
+
 int main( int argc, char* argv[])
 {
     int retVal = 0;
@@ -278,9 +567,23 @@ int main( int argc, char* argv[])
         retVal += ObliquityTest();
         retVal += GeometricMeanLongitudeSunTest();
         retVal += GeometricMeanAnomalySunTest();
+        retVal += VSOP87Test();
+        retVal += NutationTest();
+        retVal += EquationOfTimeTest();
+        retVal += AlmanacGridTest();
+        /* every tier, both ends of 1900-2100 */
+        retVal += SolarTableJobTest(1900, kSolarPrecisionFast);
+        retVal += SolarTableJobTest(1994, kSolarPrecisionMeeus);
+        retVal += SolarTableJobTest(2099, kSolarPrecisionHigh);
 
         SunRiseTests();
     }
+    else if (0 == strcmp(argv[1], "bench"))
+    {
+        retVal += BenchmarkTiers();
+        retVal += BenchmarkAlmanacGrid();
+        retVal += BenchmarkTableJob();
+    }
 
     return retVal;
 }
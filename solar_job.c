@@ -0,0 +1,415 @@
+/*
+
+  solar_job.c
+
+  Generation of large tables of solar events in a memory arena.
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015-2016 Fabrice Ferino
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+*/
+
+#ifdef __linux__
+#define _GNU_SOURCE /* pthread_setaffinity_np */
+#include <sched.h>
+#endif
+
+#include <math.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#include "solar_job.h"
+
+#define DEGRAD  ( M_PI / 180.0 )
+#define DEG2RAD(x)  ((x)*DEGRAD)
+
+#define MIN_PER_DAY (1440.0)
+
+static size_t PageSize(void)
+{
+    long pageSize = sysconf(_SC_PAGESIZE);
+    return (pageSize > 0) ? (size_t) pageSize : 4096;
+}
+
+static size_t RoundUp(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+int SolarArenaInit( SolarArena* arena, void* memory, size_t size)
+{
+    arena->base = memory;
+    arena->size = (NULL == memory) ? 0 : size;
+    arena->used = 0;
+    arena->mapped = 0;
+    return (NULL == memory) ? -1 : 0;
+}
+
+int SolarArenaCreate( SolarArena* arena, size_t size)
+{
+    size = RoundUp(size, PageSize());
+    /* anonymous pages are not backed until first written */
+    void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (MAP_FAILED == memory)
+    {
+        SolarArenaInit( arena, NULL, 0);
+        return -1;
+    }
+    SolarArenaInit( arena, memory, size);
+    arena->mapped = 1;
+    return 0;
+}
+
+void SolarArenaDestroy( SolarArena* arena)
+{
+    if (arena->mapped)
+    {
+        munmap(arena->base, arena->size);
+    }
+    SolarArenaInit( arena, NULL, 0);
+}
+
+void SolarArenaReset( SolarArena* arena)
+{
+    arena->used = 0;
+}
+
+void* SolarArenaAlloc( SolarArena* arena, size_t size, size_t alignment)
+{
+    if (alignment < SOLAR_CACHE_LINE)
+    {
+        alignment = SOLAR_CACHE_LINE;
+    }
+    if (NULL == arena->base)
+    {
+        return NULL;
+    }
+    uintptr_t start = RoundUp((uintptr_t) (arena->base + arena->used), alignment);
+    size_t offset = start - (uintptr_t) arena->base;
+
+    if (offset > arena->size || size > arena->size - offset)
+    {
+        return NULL;
+    }
+    arena->used = offset + size;
+    return arena->base + offset;
+}
+
+/* state of one thread, alone on its cache lines */
+typedef struct SolarJobWorker
+{
+    pthread_t thread;
+    const SolarTableJob* job;
+    const double* latitudesRad;
+    const double* anglesRad;
+    int firstDay;
+    int numDays;
+    int cpu;            /* pinned to this processor, -1 if not pinned */
+    double* ephemeris;  /* declination, equation of time at 0h UT, per day */
+    double* times;      /* [day][latitude][event] */
+} SolarJobWorker;
+
+#ifdef __linux__
+/* the worker-th processor the process may run on, cycling, -1 if none */
+static int SolarJobWorkerCpu( int worker)
+{
+    cpu_set_t allowed;
+    int count, cpu;
+
+    if (0 != sched_getaffinity(0, sizeof(allowed), &allowed))
+    {
+        return -1;
+    }
+    count = CPU_COUNT(&allowed);
+    if (count < 1)
+    {
+        return -1;
+    }
+    worker %= count;
+    for (cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (CPU_ISSET(cpu, &allowed) && 0 == worker--)
+        {
+            return cpu;
+        }
+    }
+    return -1;
+}
+
+static void SolarJobWorkerPin( const SolarJobWorker* w)
+{
+    cpu_set_t cpus;
+
+    if (w->cpu >= 0)
+    {
+        CPU_ZERO(&cpus);
+        CPU_SET(w->cpu, &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+}
+#else
+static int SolarJobWorkerCpu( int worker)
+{
+    return -1;
+}
+
+static void SolarJobWorkerPin( const SolarJobWorker* w)
+{
+}
+#endif
+
+/* the allocations of SolarTableJobRun, in order: for the arena size,
+   each one is counted with its worst case alignment padding */
+static size_t SolarTableJobLayout( const SolarTableJob* job, int* numDays,
+                                   int* numBlocks, int* daysPerBlock)
+{
+    size_t pageSize = PageSize();
+    double first = JulianDayEx( job->firstYear, 1, 1.0);
+    double last = JulianDayEx( job->firstYear + job->numYears, 1, 1.0);
+    long numThreads = job->numThreads;
+
+    *numDays = (int) (last - first);
+    if (numThreads <= 0)
+    {
+        numThreads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (numThreads < 1)
+    {
+        numThreads = 1;
+    }
+    if (numThreads > *numDays)
+    {
+        numThreads = *numDays;
+    }
+    *daysPerBlock = (*numDays + numThreads - 1) / numThreads;
+    *numBlocks = (*numDays + *daysPerBlock - 1) / *daysPerBlock;
+
+    size_t worker = RoundUp(sizeof(SolarJobWorker), SOLAR_CACHE_LINE);
+    size_t row = sizeof(double) * job->numLatitudes * job->numEvents;
+    size_t block = sizeof(double) * 2 * *daysPerBlock + row * *daysPerBlock;
+
+    size_t pointers = RoundUp(sizeof(void*) * *numBlocks, SOLAR_CACHE_LINE) + SOLAR_CACHE_LINE;
+
+    return 2 * pointers + worker * *numBlocks + SOLAR_CACHE_LINE +
+        RoundUp(sizeof(double) * job->numLatitudes, SOLAR_CACHE_LINE) + SOLAR_CACHE_LINE +
+        RoundUp(sizeof(double) * job->numEvents, SOLAR_CACHE_LINE) + SOLAR_CACHE_LINE +
+        (RoundUp(block, pageSize) + pageSize) * *numBlocks;
+}
+
+size_t SolarTableJobArenaSize( const SolarTableJob* job)
+{
+    int numDays, numBlocks, daysPerBlock;
+
+    if (job->numYears < 1 || job->numLatitudes < 1 || job->numEvents < 1)
+    {
+        return 0;
+    }
+    return SolarTableJobLayout( job, &numDays, &numBlocks, &daysPerBlock);
+}
+
+static void* SolarJobWorkerRun( void* arg)
+{
+    SolarJobWorker* w = arg;
+    const SolarTableJob* job = w->job;
+    double jd0 = job->firstJulianDay + w->firstDay;
+    double* t = w->times;
+    int d, l, e;
+
+    /* before the first write to the block: its pages follow this processor */
+    SolarJobWorkerPin( w);
+
+    /* first pass of UTCForSolarAngleEx: common to the whole day */
+    for (d = 0; d < w->numDays; ++d)
+    {
+        SunEphemerisEx( JulianCenturyFromJulianDay( jd0 + d), job->precision,
+                        w->ephemeris + 2 * d, w->ephemeris + 2 * d + 1);
+    }
+
+    for (d = 0; d < w->numDays; ++d)
+    {
+        double jd = jd0 + d;
+        double declinationRad = w->ephemeris[2 * d];
+        double equationOfTime = w->ephemeris[2 * d + 1];
+
+        for (l = 0; l < job->numLatitudes; ++l)
+        {
+            for (e = 0; e < job->numEvents; ++e)
+            {
+                int rise = job->events[e].rise;
+                double firstTime = UTCForSolarAngleFromEphemeris( rise, w->latitudesRad[l],
+                                                                  w->anglesRad[e],
+                                                                  declinationRad,
+                                                                  equationOfTime);
+                if (!isnan(firstTime))
+                {
+                    double secondDeclinationRad, secondEquationOfTime;
+                    SunEphemerisEx( JulianCenturyFromJulianDay( jd + firstTime / MIN_PER_DAY),
+                                    job->precision,
+                                    &secondDeclinationRad, &secondEquationOfTime);
+                    firstTime = UTCForSolarAngleFromEphemeris( rise, w->latitudesRad[l],
+                                                               w->anglesRad[e],
+                                                               secondDeclinationRad,
+                                                               secondEquationOfTime);
+                }
+                *t++ = firstTime;
+            }
+        }
+    }
+    return NULL;
+}
+
+int SolarTableJobRun( SolarTableJob* job, SolarArena* arena)
+{
+    size_t pageSize = PageSize();
+    int numDays, numBlocks, daysPerBlock;
+    int i;
+
+    if (job->numYears < 1 || job->numLatitudes < 1 || job->numEvents < 1 ||
+        NULL == job->latitudes || NULL == job->events)
+    {
+        return -1;
+    }
+    SolarTableJobLayout( job, &numDays, &numBlocks, &daysPerBlock);
+
+    struct rusage usageBefore, usageAfter;
+    struct timespec start, end;
+    getrusage(RUSAGE_SELF, &usageBefore);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    /* on failure the arena is left as it was */
+    size_t arenaUsed = arena->used;
+
+    /* everything the main thread writes comes before the page-aligned
+       blocks, so that no page of a block is first touched by it */
+    size_t workerSize = RoundUp(sizeof(SolarJobWorker), SOLAR_CACHE_LINE);
+    SolarJobWorker** workers = SolarArenaAlloc( arena, sizeof(SolarJobWorker*) * numBlocks, 0);
+    double** blocks = SolarArenaAlloc( arena, sizeof(double*) * numBlocks, 0);
+    unsigned char* workerStates = SolarArenaAlloc( arena, workerSize * numBlocks, 0);
+    double* latitudesRad = SolarArenaAlloc( arena, sizeof(double) * job->numLatitudes, 0);
+    double* anglesRad = SolarArenaAlloc( arena, sizeof(double) * job->numEvents, 0);
+    size_t row = (size_t) job->numLatitudes * job->numEvents;
+
+    if (NULL == workers || NULL == blocks || NULL == workerStates ||
+        NULL == latitudesRad || NULL == anglesRad)
+    {
+        arena->used = arenaUsed;
+        return -1;
+    }
+    for (i = 0; i < numBlocks; ++i)
+    {
+        workers[i] = (SolarJobWorker*) (workerStates + workerSize * i);
+        blocks[i] = SolarArenaAlloc( arena, sizeof(double) * (2 + row) * daysPerBlock,
+                                     pageSize);
+        if (NULL == blocks[i])
+        {
+            arena->used = arenaUsed;
+            return -1;
+        }
+    }
+    for (i = 0; i < job->numLatitudes; ++i)
+    {
+        latitudesRad[i] = DEG2RAD(job->latitudes[i]);
+    }
+    for (i = 0; i < job->numEvents; ++i)
+    {
+        anglesRad[i] = DEG2RAD(job->events[i].angle);
+    }
+
+    job->firstJulianDay = JulianDayEx( job->firstYear, 1, 1.0);
+    job->numDays = numDays;
+    job->numBlocks = numBlocks;
+    job->daysPerBlock = daysPerBlock;
+
+    for (i = 0; i < numBlocks; ++i)
+    {
+        SolarJobWorker* w = workers[i];
+
+        w->job = job;
+        w->latitudesRad = latitudesRad;
+        w->anglesRad = anglesRad;
+        w->firstDay = i * daysPerBlock;
+        w->numDays = (i + 1 == numBlocks) ? numDays - w->firstDay : daysPerBlock;
+        w->cpu = job->pinThreads ? SolarJobWorkerCpu( i) : -1;
+        /* results first: SolarTableJobTime finds them at the block start */
+        w->times = blocks[i];
+        w->ephemeris = blocks[i] + row * daysPerBlock;
+        if (i > 0 && 0 != pthread_create(&w->thread, NULL, SolarJobWorkerRun, w))
+        {
+            w->cpu = -1; /* not the calling thread */
+            SolarJobWorkerRun( w);
+            w->job = NULL;
+        }
+    }
+#ifdef __linux__
+    /* worker 0 is the calling thread: give its affinity back afterwards */
+    cpu_set_t callerCpus;
+    if (workers[0]->cpu >= 0 &&
+        0 != pthread_getaffinity_np(pthread_self(), sizeof(callerCpus), &callerCpus))
+    {
+        workers[0]->cpu = -1;
+    }
+    SolarJobWorkerRun( workers[0]);
+    if (workers[0]->cpu >= 0)
+    {
+        pthread_setaffinity_np(pthread_self(), sizeof(callerCpus), &callerCpus);
+    }
+#else
+    SolarJobWorkerRun( workers[0]);
+#endif
+    for (i = 1; i < numBlocks; ++i)
+    {
+        if (workers[i]->job)
+        {
+            pthread_join(workers[i]->thread, NULL);
+        }
+    }
+    job->blocks = blocks;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    getrusage(RUSAGE_SELF, &usageAfter);
+    job->seconds = (end.tv_sec - start.tv_sec) + 1.0e-9 * (end.tv_nsec - start.tv_nsec);
+#ifdef __APPLE__
+    /* bytes on Darwin */
+    job->peakResidentKilobytesBefore = usageBefore.ru_maxrss / 1024;
+    job->peakResidentKilobytes = usageAfter.ru_maxrss / 1024;
+#else
+    job->peakResidentKilobytesBefore = usageBefore.ru_maxrss;
+    job->peakResidentKilobytes = usageAfter.ru_maxrss;
+#endif
+    job->minorFaults = usageAfter.ru_minflt - usageBefore.ru_minflt;
+    job->majorFaults = usageAfter.ru_majflt - usageBefore.ru_majflt;
+    return 0;
+}
+
+double SolarTableJobTime( const SolarTableJob* job, int day, int latitude, int event)
+{
+    int block = day / job->daysPerBlock;
+    size_t index = ((size_t) (day - block * job->daysPerBlock) * job->numLatitudes + latitude) *
+        job->numEvents + event;
+
+    return job->blocks[block][index];
+}
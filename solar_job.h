@@ -0,0 +1,127 @@
+/*
+ solar_job.h
+
+ Generation of large tables of solar events (days x latitudes x events)
+ in a single caller-supplied or library-sized memory arena.
+
+ The MIT License (MIT)
+
+Copyright (c) 2015-2016 Fabrice Ferino
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#ifndef SOLAR_JOB_HEADER
+#define SOLAR_JOB_HEADER
+
+#include <stddef.h>
+
+#include "sunrise_sunset.h"
+
+/*
+ Bump allocator over one block of memory. Allocations are aligned on at
+ least SOLAR_CACHE_LINE bytes and never touch the memory, so that each page is
+ placed on the NUMA node of the thread that first writes it (Linux
+ default policy).
+
+ SolarArenaInit uses memory supplied by the caller; for first-touch
+ placement it should not have been written yet (fresh mmap). SolarArenaCreate
+ maps the memory itself; SolarArenaDestroy unmaps it. Both return 0 on
+ success, -1 on failure. SolarArenaAlloc returns NULL when the arena is
+ exhausted.
+*/
+#define SOLAR_CACHE_LINE (64)
+
+typedef struct SolarArena
+{
+    unsigned char* base;
+    size_t size;
+    size_t used;
+    int mapped;
+} SolarArena;
+
+int SolarArenaInit(SolarArena* arena, void* memory, size_t size);
+int SolarArenaCreate(SolarArena* arena, size_t size);
+void SolarArenaDestroy(SolarArena* arena);
+void SolarArenaReset(SolarArena* arena);
+void* SolarArenaAlloc(SolarArena* arena, size_t size, size_t alignment);
+
+/* rise (1) or set (0) with the Sun at angle from the zenith, in degrees */
+typedef struct SolarEvent
+{
+    int rise;
+    double angle;
+} SolarEvent;
+
+/*
+ UTCForSolarAngleEx for every day of [firstYear, firstYear + numYears),
+ every latitude and every event, on numThreads threads (0: one per
+ processor). The days are split in numBlocks contiguous ranges of
+ daysPerBlock days, one per thread.
+ Each thread owns a page-aligned block of the arena with its ephemeris
+ of the Sun at 0h UT (shared by all the latitudes and events of a day)
+ and its results, laid out [day][latitude][event]; nothing else is
+ allocated once the job runs.
+
+ A block is placed on the NUMA node where its thread first writes it.
+ Unless pinThreads is set, the scheduler may later move the thread to
+ another node, so placement is not guaranteed. With pinThreads (Linux
+ only, ignored elsewhere) thread i is bound to the i-th processor the
+ process may run on, cycling, before it touches its block; the calling
+ thread runs block 0 and gets its own affinity back afterwards.
+
+ SolarTableJobArenaSize returns the arena size the job needs.
+ SolarTableJobRun returns 0 on success, -1 for invalid parameters or an
+ arena too small, in which case the arena is left unchanged. It fills in the fields below "results", including the
+ wall time and page faults of the run. getrusage only keeps the peak
+ resident set size of the whole process since it started: it is recorded
+ before and after the run, and the run raised it only if they differ.
+ SolarTableJobTime returns minutes after 0h UT, as UTCForSolarAngle.
+*/
+typedef struct SolarTableJob
+{
+    int firstYear;
+    int numYears;
+    const double* latitudes;
+    int numLatitudes;
+    const SolarEvent* events;
+    int numEvents;
+    SolarPrecision precision;
+    int numThreads;
+    int pinThreads;
+
+    /* results */
+    double firstJulianDay;
+    int numDays;
+    int numBlocks;
+    int daysPerBlock;
+    double** blocks;
+    double seconds;
+    long peakResidentKilobytesBefore;
+    long peakResidentKilobytes;
+    long minorFaults;
+    long majorFaults;
+} SolarTableJob;
+
+size_t SolarTableJobArenaSize(const SolarTableJob* job);
+int SolarTableJobRun(SolarTableJob* job, SolarArena* arena);
+double SolarTableJobTime(const SolarTableJob* job, int day, int latitude, int event);
+
+
+#endif
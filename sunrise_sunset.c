@@ -32,6 +32,8 @@
 
 #include <math.h>
 
+#include "sunrise_sunset.h"
+
 #define RADEG   ( 180.0 / M_PI )
 #define DEGRAD  ( M_PI / 180.0 )
 
@@ -284,6 +286,516 @@ double EquationOfTime( double centuryTime)
     return DEG2MIN(RAD2DEG(eRad));
 }
 
+/*
+ Higher accuracy solar position: VSOP87 for the Earth as truncated in
+ Appendix III, FK5 correction and IAU 1980 nutation (ch. 22, 25, 32).
+
+ The series are stored as separate arrays of A, B and C coefficients
+ (structure of arrays) so that the summation loops below are plain
+ multiply-add / cos reductions over contiguous memory that the compiler
+ can vectorize (e.g. -O3 -ffast-math with a vector math library).
+*/
+
+typedef struct VSOP87Series
+{
+    const double* a;
+    const double* b;
+    const double* c;
+    int count;
+} VSOP87Series;
+
+#define VSOP87_SERIES(name) \
+    { name##A, name##B, name##C, (int) (sizeof(name##A) / sizeof(name##A[0])) }
+
+/* Appendix III, Earth, L0 to L5 */
+static const double kL0A[] =
+{
+    175347046.0, 3341656.0, 34894.0, 3497.0, 3418.0, 3136.0, 2676.0, 2343.0,
+    1324.0, 1273.0, 1199.0, 990.0, 902.0, 857.0, 780.0, 753.0,
+    505.0, 492.0, 357.0, 317.0, 284.0, 271.0, 243.0, 206.0,
+    205.0, 202.0, 156.0, 132.0, 126.0, 115.0, 103.0, 102.0,
+    102.0, 99.0, 98.0, 86.0, 85.0, 85.0, 80.0, 79.0,
+    75.0, 74.0, 74.0, 70.0, 62.0, 61.0, 57.0, 56.0,
+    56.0, 52.0, 52.0, 51.0, 49.0, 41.0, 41.0, 39.0,
+    37.0, 37.0, 36.0, 36.0, 33.0, 30.0, 30.0, 25.0
+};
+static const double kL0B[] =
+{
+    0.0, 4.6692568, 4.6261, 2.7441, 2.8289, 3.6277, 4.4181, 6.1352,
+    0.7425, 2.0371, 1.1096, 5.233, 2.045, 3.508, 1.179, 2.533,
+    4.583, 4.205, 2.92, 5.849, 1.899, 0.315, 0.345, 4.806,
+    1.869, 2.458, 0.833, 3.411, 1.083, 0.645, 0.636, 0.976,
+    4.267, 6.21, 0.68, 5.98, 1.3, 3.67, 1.81, 3.04,
+    1.76, 3.5, 4.68, 0.83, 3.98, 1.82, 2.78, 4.39,
+    3.47, 0.19, 1.33, 0.28, 0.49, 5.37, 2.4, 6.17,
+    6.04, 2.57, 1.71, 1.78, 0.59, 0.44, 2.74, 3.16
+};
+static const double kL0C[] =
+{
+    0.0, 6283.07585, 12566.1517, 5753.3849, 3.5231, 77713.7715, 7860.4194, 3930.2097,
+    11506.7698, 529.691, 1577.3435, 5884.927, 26.298, 398.149, 5223.694, 5507.553,
+    18849.228, 775.523, 0.067, 11790.629, 796.298, 10977.079, 5486.778, 2544.314,
+    5573.143, 6069.777, 213.299, 2942.463, 20.775, 0.98, 4694.003, 15720.839,
+    7.114, 2146.17, 155.42, 161000.69, 6275.96, 71430.7, 17260.15, 12036.46,
+    5088.63, 3154.69, 801.82, 9437.76, 8827.39, 7084.9, 6286.6, 14143.5,
+    6279.55, 12139.55, 1748.02, 5856.48, 1194.45, 8429.24, 19651.05, 10447.39,
+    10213.29, 1059.38, 2352.87, 6812.77, 17789.85, 83996.85, 1349.87, 4690.48
+};
+
+static const double kL1A[] =
+{
+    628331966747.0, 206059.0, 4303.0, 425.0, 119.0, 109.0, 93.0, 72.0,
+    68.0, 67.0, 59.0, 56.0, 45.0, 36.0, 29.0, 21.0,
+    19.0, 19.0, 17.0, 16.0, 16.0, 15.0, 12.0, 12.0,
+    12.0, 12.0, 11.0, 10.0, 10.0, 9.0, 9.0, 8.0,
+    6.0, 6.0
+};
+static const double kL1B[] =
+{
+    0.0, 2.678235, 2.6351, 1.59, 5.796, 2.966, 2.59, 1.14,
+    1.87, 4.41, 2.89, 2.17, 0.4, 0.47, 2.65, 5.34,
+    1.85, 4.97, 2.99, 0.03, 1.43, 1.21, 2.83, 3.26,
+    5.27, 2.08, 0.77, 1.3, 4.24, 2.7, 5.64, 5.3,
+    2.65, 4.67
+};
+static const double kL1C[] =
+{
+    0.0, 6283.07585, 12566.1517, 3.523, 26.298, 1577.344, 18849.23, 529.69,
+    398.15, 5507.55, 5223.69, 155.42, 796.3, 775.52, 7.11, 0.98,
+    5486.78, 213.3, 6275.96, 2544.31, 2146.17, 10977.08, 1748.02, 5088.63,
+    1194.45, 4694.0, 553.57, 6286.6, 1349.87, 242.73, 951.72, 2352.87,
+    9437.76, 4690.48
+};
+
+static const double kL2A[] =
+{
+    52919.0, 8720.0, 309.0, 27.0, 16.0, 16.0, 10.0, 9.0,
+    7.0, 5.0, 4.0, 4.0, 3.0, 3.0, 3.0, 3.0,
+    3.0, 3.0, 2.0, 2.0
+};
+static const double kL2B[] =
+{
+    0.0, 1.0721, 0.867, 0.05, 5.19, 3.68, 0.76, 2.06,
+    0.83, 4.66, 1.03, 3.44, 5.14, 6.05, 1.19, 6.12,
+    0.31, 2.28, 4.38, 3.75
+};
+static const double kL2C[] =
+{
+    0.0, 6283.0758, 12566.152, 3.52, 26.3, 155.42, 18849.23, 77713.77,
+    775.52, 1577.34, 7.11, 5573.14, 796.3, 5507.55, 242.73, 529.69,
+    398.15, 553.57, 5223.69, 0.98
+};
+
+static const double kL3A[] = { 289.0, 35.0, 17.0, 3.0, 1.0, 1.0, 1.0 };
+static const double kL3B[] = { 5.844, 0.0, 5.49, 5.2, 4.72, 5.3, 5.97 };
+static const double kL3C[] = { 6283.076, 0.0, 12566.15, 155.42, 3.52, 18849.23, 242.73 };
+
+static const double kL4A[] = { 114.0, 8.0, 1.0 };
+static const double kL4B[] = { 3.142, 4.13, 3.84 };
+static const double kL4C[] = { 0.0, 6283.08, 12566.15 };
+
+static const double kL5A[] = { 1.0 };
+static const double kL5B[] = { 3.14 };
+static const double kL5C[] = { 0.0 };
+
+/* Appendix III, Earth, B0 and B1 */
+static const double kB0A[] = { 280.0, 102.0, 80.0, 44.0, 32.0 };
+static const double kB0B[] = { 3.199, 5.422, 3.88, 3.7, 4.0 };
+static const double kB0C[] = { 84334.662, 5507.553, 5223.69, 2352.87, 1577.34 };
+
+static const double kB1A[] = { 9.0, 6.0 };
+static const double kB1B[] = { 3.9, 1.73 };
+static const double kB1C[] = { 5507.55, 5223.69 };
+
+/* Appendix III, Earth, R0 to R4 */
+static const double kR0A[] =
+{
+    100013989.0, 1670700.0, 13956.0, 3084.0, 1628.0, 1576.0, 925.0, 542.0,
+    472.0, 346.0, 329.0, 307.0, 243.0, 212.0, 186.0, 175.0,
+    110.0, 98.0, 86.0, 86.0, 65.0, 63.0, 57.0, 56.0,
+    49.0, 47.0, 45.0, 43.0, 39.0, 38.0, 37.0, 37.0,
+    36.0, 35.0, 33.0, 32.0, 32.0, 28.0, 28.0, 26.0
+};
+static const double kR0B[] =
+{
+    0.0, 3.0984635, 3.05525, 5.1985, 1.1739, 2.8469, 5.453, 4.564,
+    3.661, 0.964, 5.9, 0.299, 4.273, 5.847, 5.022, 3.012,
+    5.055, 0.89, 5.69, 1.27, 0.27, 0.92, 2.01, 5.24,
+    3.25, 2.58, 5.54, 6.01, 5.36, 2.39, 0.83, 4.9,
+    1.67, 1.84, 0.24, 0.18, 1.78, 1.21, 1.9, 4.59
+};
+static const double kR0C[] =
+{
+    0.0, 6283.07585, 12566.1517, 77713.7715, 5753.3849, 7860.4194, 11506.77, 3930.21,
+    5884.927, 5507.553, 5223.694, 5573.143, 11790.629, 1577.344, 10977.079, 18849.228,
+    5486.778, 6069.78, 15720.84, 161000.69, 17260.15, 529.69, 83996.85, 71430.7,
+    2544.31, 775.52, 9437.76, 6275.96, 4694.0, 8827.39, 19651.05, 12139.55,
+    12036.46, 2942.46, 7084.9, 5088.63, 398.15, 6286.6, 6279.55, 10447.39
+};
+
+static const double kR1A[] = { 103019.0, 1721.0, 702.0, 32.0, 31.0, 25.0, 18.0, 10.0, 9.0, 9.0 };
+static const double kR1B[] = { 1.10749, 1.0644, 3.142, 1.02, 2.84, 1.32, 1.42, 5.91, 1.42, 0.27 };
+static const double kR1C[] =
+{
+    6283.07585, 12566.1517, 0.0, 18849.23, 5507.55, 5223.69, 1577.34, 10977.08, 6275.96, 5486.78
+};
+
+static const double kR2A[] = { 4359.0, 124.0, 12.0, 9.0, 6.0, 3.0 };
+static const double kR2B[] = { 5.7846, 5.579, 3.14, 3.63, 1.87, 5.47 };
+static const double kR2C[] = { 6283.0758, 12566.152, 0.0, 77713.77, 5573.14, 18849.23 };
+
+static const double kR3A[] = { 145.0, 7.0 };
+static const double kR3B[] = { 4.273, 3.92 };
+static const double kR3C[] = { 6283.076, 12566.15 };
+
+static const double kR4A[] = { 4.0 };
+static const double kR4B[] = { 2.56 };
+static const double kR4C[] = { 6283.08 };
+
+static const VSOP87Series kEarthL[] =
+{
+    VSOP87_SERIES(kL0), VSOP87_SERIES(kL1), VSOP87_SERIES(kL2),
+    VSOP87_SERIES(kL3), VSOP87_SERIES(kL4), VSOP87_SERIES(kL5)
+};
+
+static const VSOP87Series kEarthB[] =
+{
+    VSOP87_SERIES(kB0), VSOP87_SERIES(kB1)
+};
+
+static const VSOP87Series kEarthR[] =
+{
+    VSOP87_SERIES(kR0), VSOP87_SERIES(kR1), VSOP87_SERIES(kR2),
+    VSOP87_SERIES(kR3), VSOP87_SERIES(kR4)
+};
+
+static double SumVSOP87Series( const VSOP87Series* series, double millenniumTime)
+{
+    const double* a = series->a;
+    const double* b = series->b;
+    const double* c = series->c;
+    double sum = 0.0;
+    int i;
+
+    for (i = 0; i < series->count; ++i)
+    {
+        sum += a[i] * cos(b[i] + c[i] * millenniumTime);
+    }
+    return sum;
+}
+
+/* p. 218, 32.2: L = (L0 + L1 tau + L2 tau^2 + ...) / 10^8 */
+static double SumVSOP87( const VSOP87Series* series, int count, double millenniumTime)
+{
+    double sum = 0.0;
+    int i;
+
+    for (i = count - 1; i >= 0; --i)
+    {
+        sum = sum * millenniumTime + SumVSOP87Series( series + i, millenniumTime);
+    }
+    return sum / 1.0e8;
+}
+
+/* heliocentric coordinates of the Earth, referred to the mean dynamical
+   ecliptic and equinox of the date */
+double HeliocentricLongitudeEarth( double centuryTime)
+{
+    double l = SumVSOP87( kEarthL, sizeof(kEarthL)/sizeof(kEarthL[0]), centuryTime / 10.0);
+    return NormalizeDegrees( RAD2DEG(fmod( l, 2.0 * M_PI)));
+}
+
+double HeliocentricLatitudeEarth( double centuryTime)
+{
+    double b = SumVSOP87( kEarthB, sizeof(kEarthB)/sizeof(kEarthB[0]), centuryTime / 10.0);
+    return RAD2DEG(b);
+}
+
+double RadiusVectorEarth( double centuryTime)
+{
+    return SumVSOP87( kEarthR, sizeof(kEarthR)/sizeof(kEarthR[0]), centuryTime / 10.0); /* AU */
+}
+
+/* p. 144, table 22.A: multiples of D, M, M', F, Omega and the
+   coefficients of sin (longitude) and cos (obliquity), unit 0.0001" */
+static const double kNutD[] =
+{
+     0, -2,  0,  0,  0,  0, -2,  0,  0, -2, -2, -2,  0,  2,  0,  2,
+     0,  0, -2,  0,  2,  0,  0, -2,  0, -2,  0,  0,  2, -2,  0, -2,
+     0,  0,  2,  2,  0, -2,  0,  2,  2, -2, -2,  2,  2,  0, -2, -2,
+     0, -2, -2,  0, -1, -2,  1,  0,  0, -1,  0,  0,  2,  0,  2
+};
+static const double kNutM[] =
+{
+     0,  0,  0,  0,  1,  0,  1,  0,  0, -1,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  2,  0,  2,  1,  0,
+    -1,  0,  0,  0,  1,  1, -1,  0,  0,  0,  0,  0,  0, -1, -1,  0,
+     0,  0,  1,  0,  0,  1,  0,  0,  0, -1,  1, -1, -1,  0, -1
+};
+static const double kNutMp[] =
+{
+     0,  0,  0,  0,  0,  1,  0,  0,  1,  0,  1,  0, -1,  0,  1, -1,
+    -1,  1,  2, -2,  0,  2,  2,  1,  0,  0, -1,  0, -1,  0,  0,  1,
+     0,  2, -1,  1,  0,  1,  0,  0,  1,  2,  1, -2,  0,  1,  0,  0,
+     2,  2,  0,  1,  1,  0,  0,  1, -2,  1,  1,  1, -1,  3,  0
+};
+static const double kNutF[] =
+{
+     0,  2,  2,  0,  0,  0,  2,  2,  2,  2,  0,  2,  2,  0,  0,  2,
+     0,  2,  0,  2,  2,  2,  0,  2,  2,  2,  2,  0,  0,  2,  0,  0,
+     0, -2,  2,  2,  2,  0,  2,  2,  0,  2,  2,  0,  0,  0,  2,  0,
+     2,  0,  2, -2,  0,  0,  0,  2,  2,  0,  0,  2,  2,  2,  2
+};
+static const double kNutOmega[] =
+{
+     1,  2,  2,  2,  0,  0,  2,  1,  2,  2,  0,  1,  2,  0,  1,  2,
+     1,  1,  0,  1,  2,  2,  0,  2,  0,  0,  1,  0,  1,  2,  1,  1,
+     1,  0,  1,  2,  2,  0,  2,  1,  0,  2,  1,  1,  1,  0,  1,  1,
+     1,  1,  1,  0,  0,  0,  0,  0,  2,  0,  0,  2,  2,  2,  2
+};
+static const double kNutPsi0[] =
+{
+    -171996, -13187, -2274, 2062, 1426, 712, -517, -386, -301, 217, -158, 129, 123, 63, 63, -59,
+    -58, -51, 48, 46, -38, -31, 29, 29, 26, -22, 21, 17, 16, -16, -15, -13,
+    -12, 11, -10, -8, 7, -7, -7, -7, 6, 6, 6, -6, -6, 5, -5, -5,
+    -5, 4, 4, 4, -4, -4, -4, 3, -3, -3, -3, -3, -3, -3, -3
+};
+static const double kNutPsi1[] =
+{
+    -174.2, -1.6, -0.2, 0.2, -3.4, 0.1, 1.2, -0.4, 0, -0.5, 0, 0.1, 0, 0, 0.1, 0,
+    -0.1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -0.1, 0, 0.1, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+static const double kNutEps0[] =
+{
+    92025, 5736, 977, -895, 54, -7, 224, 200, 129, -95, 0, -70, -53, 0, -33, 26,
+    32, 27, 0, -24, 16, 13, 0, -12, 0, 0, -10, 0, -8, 7, 9, 7,
+    6, 0, 5, 3, -3, 0, 3, 3, 0, -3, -3, 3, 3, 0, 3, 3,
+    3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+static const double kNutEps1[] =
+{
+    8.9, -3.1, -0.5, 0.5, -0.1, 0, -0.6, 0, -0.1, 0.3, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+#define NUTATION_TERMS ((int) (sizeof(kNutPsi0) / sizeof(kNutPsi0[0])))
+
+/* p. 143-144: nutation in longitude and obliquity, in degrees */
+void Nutation( double centuryTime, double* deltaPsi, double* deltaEpsilon)
+{
+    double t = centuryTime;
+    /* mean elongation of the Moon from the Sun */
+    double d = DEG2RAD(297.85036 + t * (445267.111480 + t * (-0.0019142 + t / 189474.0)));
+    /* mean anomaly of the Sun (Earth) */
+    double m = DEG2RAD(357.52772 + t * (35999.050340 + t * (-0.0001603 - t / 300000.0)));
+    /* mean anomaly of the Moon */
+    double mp = DEG2RAD(134.96298 + t * (477198.867398 + t * (0.0086972 + t / 56250.0)));
+    /* Moon's argument of latitude */
+    double f = DEG2RAD(93.27191 + t * (483202.017538 + t * (-0.0036825 + t / 327270.0)));
+    /* longitude of the ascending node of the Moon's mean orbit */
+    double omega = DEG2RAD(125.04452 + t * (-1934.136261 + t * (0.0020708 + t / 450000.0)));
+    double psi = 0.0, epsilon = 0.0;
+    int i;
+
+    for (i = 0; i < NUTATION_TERMS; ++i)
+    {
+        double argument = kNutD[i] * d + kNutM[i] * m + kNutMp[i] * mp +
+            kNutF[i] * f + kNutOmega[i] * omega;
+        psi += (kNutPsi0[i] + kNutPsi1[i] * t) * sin(argument);
+        epsilon += (kNutEps0[i] + kNutEps1[i] * t) * cos(argument);
+    }
+
+    *deltaPsi = psi / (10000.0 * 3600.0);
+    *deltaEpsilon = epsilon / (10000.0 * 3600.0);
+}
+
+/* p. 147, 22.3 (Laskar) */
+double MeanObliquityEclipticLaskar( double centuryTime)
+{
+    double u = centuryTime / 100.0;
+    double arcSeconds = 84381.448 + u *
+        (-4680.93 + u *
+         (-1.55 + u *
+          (1999.25 + u *
+           (-51.38 + u *
+            (-249.67 + u *
+             (-39.05 + u *
+              (7.12 + u *
+               (27.87 + u *
+                (5.79 + u * 2.45)))))))));
+    return arcSeconds / 3600.0;
+}
+
+/* apparent right ascension, declination (radians) and equation of time
+   (minutes), sharing one evaluation of the series */
+static void SunPositionHigh( double centuryTime,
+                             double* rightAscensionRad,
+                             double* declinationRad,
+                             double* equationOfTime)
+{
+    double t = centuryTime;
+    double tau = t / 10.0;
+    double deltaPsi, deltaEpsilon;
+
+    /* geocentric longitude and latitude, p. 166 */
+    double theta = HeliocentricLongitudeEarth( t) + 180.0;
+    double beta = -HeliocentricLatitudeEarth( t);
+    double r = RadiusVectorEarth( t);
+
+    /* conversion to the FK5 system, p. 219, 32.3 */
+    double lambdaPrime = DEG2RAD(theta - t * (1.397 + t * 0.00031));
+    theta -= 0.09033 / 3600.0;
+    beta += (0.03916 / 3600.0) * (cos(lambdaPrime) - sin(lambdaPrime));
+
+    Nutation( t, &deltaPsi, &deltaEpsilon);
+
+    /* aberration, p. 167, 25.10 */
+    double lambda = theta + deltaPsi - 20.4898 / (3600.0 * r);
+    double epsilon = MeanObliquityEclipticLaskar( t) + deltaEpsilon;
+
+    double lambdaRad = DEG2RAD(lambda);
+    double betaRad = DEG2RAD(beta);
+    double epsilonRad = DEG2RAD(epsilon);
+    double sinLambda = sin(lambdaRad);
+    double sinEpsilon = sin(epsilonRad);
+    double cosEpsilon = cos(epsilonRad);
+
+    /* p. 93, 13.3 and 13.4 */
+    double alpha = atan2( sinLambda * cosEpsilon - tan(betaRad) * sinEpsilon,
+                          cos(lambdaRad));
+    *rightAscensionRad = alpha;
+    *declinationRad = asin( sin(betaRad) * cosEpsilon +
+                            cos(betaRad) * sinEpsilon * sinLambda);
+
+    /* p. 183, 28.2 and 28.1 */
+    double l0 = 280.4664567 + tau *
+        (360007.6982779 + tau *
+         (0.03032028 + tau *
+          (1.0 / 49931.0 + tau *
+           (-1.0 / 15300.0 - tau / 2000000.0))));
+    double e = NormalizeDegrees( l0 - 0.0057183 - RAD2DEG(alpha) +
+                                 deltaPsi * cosEpsilon);
+    if (e > 180.0)
+    {
+        e -= 360.0;
+    }
+    *equationOfTime = DEG2MIN(e);
+}
+
+/*
+ Fast tier: the ch. 25 series truncated to first order in T, nutation
+ dropped, e and y of 28.3 held at their J2000 values. Declination, right
+ ascension and equation of time all come from sin M, cos M, sin L0 and
+ cos L0: the multiple angles follow from the double angle formulas, the
+ small equation of center and the obliquity drift from short series.
+ One evaluation costs two sine/cosine pairs and the final asin or atan2.
+*/
+#define FAST_ECCENTRICITY (0.016708634)
+#define FAST_Y            (0.0430345)           /* tan^2(23.439291/2) */
+#define FAST_SIN_EPSILON  (0.397777154152682)   /* sin(23.439291) */
+#define FAST_COS_EPSILON  (0.917482062840573)   /* cos(23.439291) */
+
+static void SunFast( double centuryTime,
+                     double* sinLambda, double* cosLambda,
+                     double* sinEpsilon, double* cosEpsilon,
+                     double* equationOfTime)
+{
+    double l0 = DEG2RAD(280.46646 + 36000.76983 * centuryTime);
+    double m = DEG2RAD(357.52911 + 35999.05029 * centuryTime);
+    double sinm = sin(m);
+    double cosm = cos(m);
+    double sinl0 = sin(l0);
+    double cosl0 = cos(l0);
+
+    /* lambda = L0 + x, |x| < 2 deg */
+    double x = DEG2RAD(1.914602 * sinm + 0.039986 * sinm * cosm - 0.00569); /* 0.019993 sin 2M */
+    double x2 = x * x;
+    double sinx = x * (1.0 - x2 / 6.0 * (1.0 - x2 / 20.0));
+    double cosx = 1.0 - x2 / 2.0 * (1.0 - x2 / 12.0);
+    *sinLambda = sinl0 * cosx + cosl0 * sinx;
+    *cosLambda = cosl0 * cosx - sinl0 * sinx;
+
+    /* epsilon = 23.439291 + d, |d| < 0.02 deg over +/- 1 century */
+    double d = DEG2RAD(-0.0130042 * centuryTime);
+    *sinEpsilon = FAST_SIN_EPSILON * (1.0 - d * d / 2.0) + FAST_COS_EPSILON * d;
+    *cosEpsilon = FAST_COS_EPSILON * (1.0 - d * d / 2.0) - FAST_SIN_EPSILON * d;
+
+    double sin2l0 = 2.0 * sinl0 * cosl0;
+    double cos2l0 = cosl0 * cosl0 - sinl0 * sinl0;
+    double y = FAST_Y;
+    double e = FAST_ECCENTRICITY;
+
+    double eRad = y * sin2l0 - 2.0 * e * sinm + 4.0 * e * y * sinm * cos2l0 -
+        y * y * sin2l0 * cos2l0 - 2.5 * e * e * sinm * cosm;
+
+    *equationOfTime = DEG2MIN(RAD2DEG(eRad));
+}
+
+static void SunEphemerisFast( double centuryTime, double* declinationRad,
+                              double* equationOfTime)
+{
+    double sinLambda, cosLambda, sinEpsilon, cosEpsilon;
+
+    SunFast( centuryTime, &sinLambda, &cosLambda, &sinEpsilon, &cosEpsilon,
+             equationOfTime);
+    *declinationRad = asin( sinEpsilon * sinLambda);
+}
+
+double SunRightAscensionRadEx( double centuryTime, SolarPrecision precision)
+{
+    double sinLambda, cosLambda, sinEpsilon, cosEpsilon, alpha, delta, e;
+
+    switch (precision)
+    {
+        case kSolarPrecisionFast:
+            SunFast( centuryTime, &sinLambda, &cosLambda, &sinEpsilon, &cosEpsilon, &e);
+            return atan2( cosEpsilon * sinLambda, cosLambda);
+        case kSolarPrecisionHigh:
+            SunPositionHigh( centuryTime, &alpha, &delta, &e);
+            return alpha;
+        default:
+            return SunRightAscensionRad( centuryTime);
+    }
+}
+
+double SunDeclinationRadEx( double centuryTime, SolarPrecision precision)
+{
+    double alpha, delta, e;
+
+    switch (precision)
+    {
+        case kSolarPrecisionFast:
+            SunEphemerisFast( centuryTime, &delta, &e);
+            return delta;
+        case kSolarPrecisionHigh:
+            SunPositionHigh( centuryTime, &alpha, &delta, &e);
+            return delta;
+        default:
+            return SunDeclinationRad( centuryTime);
+    }
+}
+
+double EquationOfTimeEx( double centuryTime, SolarPrecision precision)
+{
+    double alpha, delta, e;
+
+    switch (precision)
+    {
+        case kSolarPrecisionFast:
+            SunEphemerisFast( centuryTime, &delta, &e);
+            return e;
+        case kSolarPrecisionHigh:
+            SunPositionHigh( centuryTime, &alpha, &delta, &e);
+            return e;
+        default:
+            return EquationOfTime( centuryTime);
+    }
+}
+
 
 /* http://www.esrl.noaa.gov/gmd/grad/solcalc/solareqns.PDF */
 /* calculate the hour angle of the sun when it's at angle at the latitude */
@@ -327,6 +839,68 @@ double UTCForSolarAngle( int rise, double jd, double latitude,
     return secondTime; /* minutes */
 }
 
+/* declination (radians) and equation of time (minutes) in one call */
+void SunEphemerisEx( double centuryTime, SolarPrecision precision,
+                     double* declinationRad, double* equationOfTime)
+{
+    double sunRightAscensionRad;
+
+    if (precision == kSolarPrecisionHigh)
+    {
+        SunPositionHigh( centuryTime, &sunRightAscensionRad, declinationRad,
+                         equationOfTime);
+    }
+    else if (precision == kSolarPrecisionFast)
+    {
+        SunEphemerisFast( centuryTime, declinationRad, equationOfTime);
+    }
+    else
+    {
+        *equationOfTime = EquationOfTimeEx( centuryTime, precision);
+        *declinationRad = SunDeclinationRadEx( centuryTime, precision);
+    }
+}
+
+/* one step of UTCForSolarAngleAuxEx, from the ephemeris of the Sun */
+double UTCForSolarAngleFromEphemeris( int rise, double latitudeRad,
+                                      double angleRad,
+                                      double declinationRad,
+                                      double equationOfTime)
+{
+    double hourAngle = LocalHourAngleSunRad( latitudeRad, declinationRad,
+                                             angleRad);
+    if (!rise) { hourAngle = -hourAngle; }
+
+    return 720.0 - (4.0 * RAD2DEG(hourAngle)) - equationOfTime; /* minutes */
+}
+
+double UTCForSolarAngleAuxEx( int rise, double jd,
+                              double latitudeRad,
+                              double angleRad,
+                              SolarPrecision precision)
+{
+    double centuryTime = JulianCenturyFromJulianDay( jd);
+    double equationOfTime, sunDeclinationRad;
+
+    SunEphemerisEx( centuryTime, precision, &sunDeclinationRad, &equationOfTime);
+
+    return UTCForSolarAngleFromEphemeris( rise, latitudeRad, angleRad,
+                                          sunDeclinationRad, equationOfTime);
+}
+
+double UTCForSolarAngleEx( int rise, double jd, double latitude,
+                           double angle, SolarPrecision precision)
+{
+    double latitudeRad = DEG2RAD(latitude);
+    double angleRad = DEG2RAD( angle);
+
+    double firstTime = UTCForSolarAngleAuxEx( rise, jd, latitudeRad, angleRad,
+                                              precision);
+    double secondTime = UTCForSolarAngleAuxEx( rise, jd + firstTime / MIN_PER_DAY,
+                                               latitudeRad, angleRad, precision);
+    return secondTime; /* minutes */
+}
+
 /* p. 61, 7.1 */
 double JulianDayEx( int y, int m, double dayFrac)
 {
@@ -63,6 +63,47 @@ double EquationOfTime(double centuryTime);
 double LocalHourAngleSunRad(double latitudeRad, double declinationRad, double angleRad);
 double UTCForSolarAngleAux(int rise, double jd, double latitudeRad, double angleRad);
 double UTCForSolarAngle(int rise, double jd, double latitude, double angle);
+
+/*
+ Precision tiers for the solar position (declination, right ascension,
+ equation of time). Error bounds are the maximum differences to the
+ high precision tier over 1900-2100, rise/set times for |latitude| <= 60
+ (run "solar_times bench"). Timings: x86-64, gcc -O2, per call.
+
+ kSolarPrecisionFast:  truncated ch. 25 series, no nutation, constant
+                       eccentricity. Declination < 24", equation of time
+                       < 5 s, rise/set < 7 s. 70 ns, 0.4 us per rise/set.
+ kSolarPrecisionMeeus: ch. 25 low precision series, Omega-only nutation,
+                       as used by the functions above. Declination < 21",
+                       equation of time < 4 s, rise/set < 6 s. 170 ns,
+                       0.8 us per rise/set.
+ kSolarPrecisionHigh:  VSOP87 (Appendix III), FK5, IAU 1980 nutation.
+                       About 1" with centuryTime in dynamical time.
+                       9 us, 11 us per rise/set.
+*/
+typedef enum SolarPrecision
+{
+    kSolarPrecisionFast,
+    kSolarPrecisionMeeus,
+    kSolarPrecisionHigh
+} SolarPrecision;
+
+double HeliocentricLongitudeEarth(double centuryTime);
+double HeliocentricLatitudeEarth(double centuryTime);
+double RadiusVectorEarth(double centuryTime);
+void Nutation(double centuryTime, double* deltaPsi, double* deltaEpsilon);
+double MeanObliquityEclipticLaskar(double centuryTime);
+double SunRightAscensionRadEx(double centuryTime, SolarPrecision precision);
+double SunDeclinationRadEx(double centuryTime, SolarPrecision precision);
+double EquationOfTimeEx(double centuryTime, SolarPrecision precision);
+void SunEphemerisEx(double centuryTime, SolarPrecision precision,
+                    double* declinationRad, double* equationOfTime);
+double UTCForSolarAngleFromEphemeris(int rise, double latitudeRad, double angleRad,
+                                     double declinationRad, double equationOfTime);
+double UTCForSolarAngleAuxEx(int rise, double jd, double latitudeRad, double angleRad,
+                             SolarPrecision precision);
+double UTCForSolarAngleEx(int rise, double jd, double latitude, double angle,
+                          SolarPrecision precision);
 double JulianDayEx(int y, int m, double dayFrac);
 double JulianDay(int year, int month, int day, int hour, int minute, int second);
 void D2DMS( double degreesFrac, int* degrees, int* minutes, double* seconds);
@@ -0,0 +1,897 @@
+/*
+  validate.c
+
+  SolarTimes
+
+  Differential validation of the alternative computation paths (precision
+  tiers, latitude grid, ...) against the reference routines UTCForSolarAngle and
+  EquationOfTime of sunrise_sunset.c/.h, and of all of them against
+  golden tables in the Nautical Almanac layout.
+
+  usage: solar_validate [-n samples] [-t threads] [-s seed] [-e minutes] [-g golden]...
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015-2016 Fabrice Ferino
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "sunrise_sunset.h"
+#include "almanac_grid.h"
+
+#define DEGRAD  ( M_PI / 180.0 )
+
+/* one input of the differential sweep */
+typedef struct ValidationSample
+{
+    double jd;
+    double latitude;
+    double angle;
+    int rise;
+} ValidationSample;
+
+/* cache is private to the calling thread and path, initially NULL */
+typedef double (*ValidationFunction)(const ValidationSample* s, void** cache);
+typedef void (*ValidationRelease)(void* cache);
+
+typedef enum ValidationKind
+{
+    kValidateEventTime,     /* compared to UTCForSolarAngle */
+    kValidateEquationOfTime /* compared to EquationOfTime */
+} ValidationKind;
+
+/* a computation path and the largest difference to the reference, in
+   seconds of time, accepted on well-conditioned samples. Paths with a
+   per-day setup draw their random samples from a separate stream where
+   samplesPerEvent consecutive samples share the day and the event; the
+   others see independent samples (samplesPerEvent 1). */
+typedef struct ValidationPath
+{
+    const char* name;
+    ValidationKind kind;
+    ValidationFunction function;
+    ValidationRelease release;
+    double boundSeconds;
+    int samplesPerEvent;
+} ValidationPath;
+
+static double ReferenceEventTime(const ValidationSample* s)
+{
+    return UTCForSolarAngle(s->rise, s->jd, s->latitude, s->angle);
+}
+
+static double ReferenceEquationOfTime(const ValidationSample* s)
+{
+    return EquationOfTime(JulianCenturyFromJulianDay(s->jd));
+}
+
+static double FastEventTime(const ValidationSample* s, void** cache)
+{
+    return UTCForSolarAngleEx(s->rise, s->jd, s->latitude, s->angle, kSolarPrecisionFast);
+}
+
+static double MeeusEventTime(const ValidationSample* s, void** cache)
+{
+    return UTCForSolarAngleEx(s->rise, s->jd, s->latitude, s->angle, kSolarPrecisionMeeus);
+}
+
+static double HighEventTime(const ValidationSample* s, void** cache)
+{
+    return UTCForSolarAngleEx(s->rise, s->jd, s->latitude, s->angle, kSolarPrecisionHigh);
+}
+
+static double FastEquationOfTime(const ValidationSample* s, void** cache)
+{
+    return EquationOfTimeEx(JulianCenturyFromJulianDay(s->jd), kSolarPrecisionFast);
+}
+
+static double MeeusEquationOfTime(const ValidationSample* s, void** cache)
+{
+    return EquationOfTimeEx(JulianCenturyFromJulianDay(s->jd), kSolarPrecisionMeeus);
+}
+
+static double HighEquationOfTime(const ValidationSample* s, void** cache)
+{
+    return EquationOfTimeEx(JulianCenturyFromJulianDay(s->jd), kSolarPrecisionHigh);
+}
+
+/* 2 degree grid, 0.05 minute tolerance, rebuilt when the day or the
+   event changes; 32 latitudes per grid in the random sweep */
+#define GRID_TOLERANCE (0.05)
+#define GRID_SAMPLES_PER_EVENT (32)
+
+typedef struct GridCache
+{
+    AlmanacGrid* grid;
+    double jd;
+    double angle;
+    int rise;
+} GridCache;
+
+/* without memory for the cache or the grid, the exact solver answers */
+static double GridEventTime(const ValidationSample* s, void** cache)
+{
+    GridCache* c = *cache;
+
+    if (NULL == c)
+    {
+        c = *cache = calloc(1, sizeof(GridCache));
+        if (NULL == c)
+        {
+            return MeeusEventTime(s, cache);
+        }
+    }
+    if (NULL == c->grid || c->jd != s->jd || c->angle != s->angle || c->rise != s->rise)
+    {
+        double latitudes[90];
+        int i;
+
+        for (i = 0; i < 90; ++i)
+        {
+            latitudes[i] = -89.0 + 2.0 * i;
+        }
+        AlmanacGridDestroy(c->grid);
+        c->grid = AlmanacGridCreate(s->jd, s->rise, s->angle, latitudes, 90,
+                                    GRID_TOLERANCE, kSolarPrecisionMeeus);
+        c->jd = s->jd;
+        c->angle = s->angle;
+        c->rise = s->rise;
+        if (NULL == c->grid)
+        {
+            return MeeusEventTime(s, cache);
+        }
+    }
+    return AlmanacGridUTC(c->grid, s->latitude);
+}
+
+static void GridRelease(void* cache)
+{
+    GridCache* c = cache;
+
+    if (c)
+    {
+        AlmanacGridDestroy(c->grid);
+        free(c);
+    }
+}
+
+/* every alternative path is registered here. The table job of solar_job.h
+   is not: it must match UTCForSolarAngleEx bit for bit, which the built-in
+   tests of solar_times check for every tier, so the utc/ paths cover it */
+static const ValidationPath kPaths[] =
+{
+    { "utc/fast",  kValidateEventTime,      FastEventTime,       NULL,        10.0, 1 },
+    { "utc/meeus", kValidateEventTime,      MeeusEventTime,      NULL,         0.0, 1 },
+    { "utc/high",  kValidateEventTime,      HighEventTime,       NULL,        10.0, 1 },
+    { "utc/grid",  kValidateEventTime,      GridEventTime,       GridRelease,  GRID_TOLERANCE * 60.0,
+      GRID_SAMPLES_PER_EVENT },
+    { "eot/fast",  kValidateEquationOfTime, FastEquationOfTime,  NULL,         2.5, 1 },
+    { "eot/meeus", kValidateEquationOfTime, MeeusEquationOfTime, NULL,         0.0, 1 },
+    { "eot/high",  kValidateEquationOfTime, HighEquationOfTime,  NULL,         5.0, 1 }
+};
+
+#define NUM_PATHS ((int) (sizeof(kPaths) / sizeof(kPaths[0])))
+
+/*
+ Near the polar day/night limits and at the poles a small change of the
+ declination moves the rise or set time by an unbounded amount. Event
+ times whose sensitivity d(hour angle)/d(declination) exceeds this value
+ are ill-conditioned: they are reported but not held to the bound.
+*/
+#define MAX_CONDITION (4.0)
+
+/* histogram of absolute errors in seconds: bin 0 holds exact matches,
+   then 8 bins per decade from 1e-9 s */
+#define HISTOGRAM_MIN_LOG10     (-9)
+#define HISTOGRAM_BINS_PER_DECADE (8)
+#define HISTOGRAM_DECADES       (14)
+#define HISTOGRAM_BINS          (2 + HISTOGRAM_BINS_PER_DECADE * HISTOGRAM_DECADES)
+
+#define WORST_CASES (3)
+
+typedef struct WorstCase
+{
+    double error;       /* seconds */
+    double reference;   /* minutes */
+    double value;       /* minutes */
+    ValidationSample sample;
+} WorstCase;
+
+typedef struct PathStatistics
+{
+    uint64_t histogram[HISTOGRAM_BINS];
+    uint64_t compared;        /* both results finite */
+    uint64_t illConditioned;  /* of which not held to the bound, nor histogrammed */
+    uint64_t nanMismatches;   /* one result finite, the other not */
+    uint64_t failures;        /* above the bound or well-conditioned NaN mismatch */
+    double maxError;
+    double maxIllConditioned;
+    WorstCase worst[WORST_CASES];
+} PathStatistics;
+
+typedef struct ValidationThread
+{
+    pthread_t thread;
+    uint64_t seed;
+    uint64_t begin;
+    uint64_t end;
+    const ValidationSample* edgeCases;
+    uint64_t numEdgeCases;
+    void* cache[NUM_PATHS];
+    PathStatistics statistics[NUM_PATHS];
+} ValidationThread;
+
+/* splitmix64: sample i only depends on (seed, i), so results do not
+   depend on the number of threads and any sample can be replayed */
+static uint64_t SplitMix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static double UniformFromBits(uint64_t bits)
+{
+    return (bits >> 11) * (1.0 / 9007199254740992.0); /* [0, 1) */
+}
+
+/* sample index of the stream where samplesPerEvent consecutive samples
+   share the day and the event; each group size is a separate stream */
+static void RandomSample(uint64_t seed, int samplesPerEvent, uint64_t index,
+                         ValidationSample* s)
+{
+    static const double* const kAngles[] =
+    {
+        &kRiseOrSet, &kCivilTwilight, &kNauticalTwilight, &kAstronomicalTwilight
+    };
+    static const double jdStart = 2415020.5; /* 1900 January 1 */
+    static const double jdSpan = 73049.0;    /* to 2100 January 1 */
+
+    uint64_t stream = SplitMix64(seed + (uint64_t) (samplesPerEvent - 1));
+    uint64_t state = SplitMix64(stream ^ SplitMix64(index / samplesPerEvent));
+    uint64_t choice;
+
+    s->jd = jdStart + floor(jdSpan * UniformFromBits(state));
+    state = SplitMix64(state);
+    choice = state >> 60;
+    if (choice < 8)
+    {
+        s->angle = *kAngles[choice & 3];
+    }
+    else
+    {
+        s->angle = 85.0 + 25.0 * UniformFromBits(state);
+    }
+    state = SplitMix64(state);
+    s->rise = (int) (state >> 63);
+    state = SplitMix64(stream ^ SplitMix64(~index));
+    s->latitude = -90.0 + 180.0 * UniformFromBits(state);
+}
+
+/* dates, latitudes and angles where the algorithms are most fragile */
+static ValidationSample* EdgeCases(uint64_t* count)
+{
+    static const int kDates[][3] =
+    {
+        { 1900, 1, 1 }, { 1900, 3, 1 }, { 1999, 12, 31 }, { 2000, 1, 1 },
+        { 2000, 2, 29 }, { 2000, 3, 20 }, { 2000, 6, 21 }, { 2000, 9, 22 },
+        { 2000, 12, 21 }, { 2024, 3, 20 }, { 2024, 6, 20 }, { 2024, 12, 21 },
+        { 2099, 12, 31 }
+    };
+    static const double kEdgeLatitudes[] =
+    {
+        90.0, 89.999, 80.0, 72.0, 66.56, 66.0, 60.0, 45.0, 0.0,
+        -45.0, -60.0, -66.0, -66.56, -72.0, -80.0, -89.999, -90.0
+    };
+    const double angles[] =
+    {
+        90.0, kRiseOrSet, kCivilTwilight, kNauticalTwilight, kAstronomicalTwilight
+    };
+    const int numDates = sizeof(kDates) / sizeof(kDates[0]);
+    const int numLatitudes = sizeof(kEdgeLatitudes) / sizeof(kEdgeLatitudes[0]);
+    const int numAngles = sizeof(angles) / sizeof(angles[0]);
+    ValidationSample* samples = malloc(sizeof(ValidationSample) * 2 *
+                                       numDates * numLatitudes * numAngles);
+    uint64_t n = 0;
+    int d, l, a, rise;
+
+    if (NULL == samples)
+    {
+        *count = 0;
+        return NULL;
+    }
+    /* latitude innermost: one grid per date and event */
+    for (d = 0; d < numDates; ++d)
+    {
+        for (a = 0; a < numAngles; ++a)
+        {
+            for (rise = 0; rise <= 1; ++rise)
+            {
+                for (l = 0; l < numLatitudes; ++l)
+                {
+                    ValidationSample* s = samples + n++;
+                    s->jd = JulianDayEx(kDates[d][0], kDates[d][1], kDates[d][2]);
+                    s->latitude = kEdgeLatitudes[l];
+                    s->angle = angles[a];
+                    s->rise = rise;
+                }
+            }
+        }
+    }
+    *count = n;
+    return samples;
+}
+
+/* sensitivity of the reference event time to the declination,
+   dH/ddelta = (tan phi - cos H tan delta) / sin H */
+static double EventCondition(const ValidationSample* s, double reference)
+{
+    double centuryTime = JulianCenturyFromJulianDay(s->jd + reference / 1440.0);
+    double declinationRad = SunDeclinationRad(centuryTime);
+    double latitudeRad = s->latitude * DEGRAD;
+    double hourAngle = LocalHourAngleSunRad(latitudeRad, declinationRad,
+                                            s->angle * DEGRAD);
+
+    return fabs(tan(latitudeRad) - cos(hourAngle) * tan(declinationRad)) /
+        fabs(sin(hourAngle));
+}
+
+static int HistogramBin(double error)
+{
+    if (error <= 0.0)
+    {
+        return 0;
+    }
+    int bin = 1 + (int) floor((log10(error) - HISTOGRAM_MIN_LOG10) *
+                              HISTOGRAM_BINS_PER_DECADE);
+    if (bin < 1)
+    {
+        bin = 1;
+    }
+    if (bin >= HISTOGRAM_BINS)
+    {
+        bin = HISTOGRAM_BINS - 1;
+    }
+    return bin;
+}
+
+/* upper edge of a histogram bin, seconds */
+static double HistogramBinLimit(int bin)
+{
+    if (0 == bin)
+    {
+        return 0.0;
+    }
+    return pow(10.0, HISTOGRAM_MIN_LOG10 + (double) bin / HISTOGRAM_BINS_PER_DECADE);
+}
+
+static void RecordWorstCase(PathStatistics* p, const WorstCase* w)
+{
+    int i = WORST_CASES - 1;
+
+    if (w->error <= p->worst[i].error)
+    {
+        return;
+    }
+    while (i > 0 && w->error > p->worst[i - 1].error)
+    {
+        p->worst[i] = p->worst[i - 1];
+        --i;
+    }
+    p->worst[i] = *w;
+}
+
+/* s is checked on the paths drawing from the stream of samplesPerEvent,
+   on all the paths for 0 */
+static void ValidateSample(ValidationThread* t, const ValidationSample* s,
+                           int samplesPerEvent)
+{
+    double referenceTime = ReferenceEventTime(s);
+    double referenceEot = ReferenceEquationOfTime(s);
+    double condition = -1.0;
+    int i;
+
+    for (i = 0; i < NUM_PATHS; ++i)
+    {
+        const ValidationPath* path = kPaths + i;
+        PathStatistics* p = t->statistics + i;
+
+        if (samplesPerEvent && path->samplesPerEvent != samplesPerEvent)
+        {
+            continue;
+        }
+
+        double reference = (kValidateEventTime == path->kind) ? referenceTime : referenceEot;
+        double value = path->function(s, t->cache + i);
+        int wellConditioned = 1;
+
+        if (kValidateEventTime == path->kind)
+        {
+            /* a missing reference event is judged on the path's event */
+            double event = isnan(referenceTime) ? value : referenceTime;
+            if (isnan(referenceTime) || condition < 0.0)
+            {
+                condition = isnan(event) ? INFINITY : EventCondition(s, event);
+            }
+            wellConditioned = condition <= MAX_CONDITION;
+        }
+
+        if (isnan(reference) || isnan(value))
+        {
+            if (isnan(reference) != isnan(value))
+            {
+                ++p->nanMismatches;
+                if (wellConditioned)
+                {
+                    WorstCase w = { INFINITY, reference, value, *s };
+                    ++p->failures;
+                    RecordWorstCase(p, &w);
+                }
+            }
+            continue;
+        }
+
+        double error = fabs(value - reference) * 60.0; /* seconds */
+        ++p->compared;
+        if (!wellConditioned)
+        {
+            ++p->illConditioned;
+            p->maxIllConditioned = fmax(p->maxIllConditioned, error);
+            continue;
+        }
+        ++p->histogram[HistogramBin(error)];
+        if (error > p->maxError)
+        {
+            p->maxError = error;
+        }
+        if (error > path->boundSeconds)
+        {
+            ++p->failures;
+        }
+        WorstCase w = { error, reference, value, *s };
+        RecordWorstCase(p, &w);
+    }
+}
+
+static void* ValidationWorker(void* arg)
+{
+    ValidationThread* t = arg;
+    ValidationSample s;
+    uint64_t i;
+    int k, j;
+
+    for (i = 0; i < t->numEdgeCases; ++i)
+    {
+        ValidateSample(t, t->edgeCases + i, 0);
+    }
+    /* one pass per stream, in the order of the first path using it */
+    for (k = 0; k < NUM_PATHS; ++k)
+    {
+        int samplesPerEvent = kPaths[k].samplesPerEvent;
+        int done = 0;
+
+        for (j = 0; j < k; ++j)
+        {
+            done = done || kPaths[j].samplesPerEvent == samplesPerEvent;
+        }
+        if (done)
+        {
+            continue;
+        }
+        for (i = t->begin; i < t->end; ++i)
+        {
+            RandomSample(t->seed, samplesPerEvent, i, &s);
+            ValidateSample(t, &s, samplesPerEvent);
+        }
+    }
+    for (i = 0; i < NUM_PATHS; ++i)
+    {
+        if (kPaths[i].release)
+        {
+            kPaths[i].release(t->cache[i]);
+        }
+    }
+    return NULL;
+}
+
+static void MergeStatistics(PathStatistics* into, const PathStatistics* from)
+{
+    int i;
+
+    for (i = 0; i < HISTOGRAM_BINS; ++i)
+    {
+        into->histogram[i] += from->histogram[i];
+    }
+    into->compared += from->compared;
+    into->illConditioned += from->illConditioned;
+    into->nanMismatches += from->nanMismatches;
+    into->failures += from->failures;
+    into->maxError = fmax(into->maxError, from->maxError);
+    into->maxIllConditioned = fmax(into->maxIllConditioned, from->maxIllConditioned);
+    for (i = 0; i < WORST_CASES; ++i)
+    {
+        RecordWorstCase(into, from->worst + i);
+    }
+}
+
+static double Percentile(const PathStatistics* p, double fraction)
+{
+    uint64_t target = (uint64_t) ceil(fraction * (p->compared - p->illConditioned));
+    uint64_t cumulated = 0;
+    int i;
+
+    for (i = 0; i < HISTOGRAM_BINS; ++i)
+    {
+        cumulated += p->histogram[i];
+        if (cumulated >= target)
+        {
+            return HistogramBinLimit(i);
+        }
+    }
+    return HistogramBinLimit(HISTOGRAM_BINS - 1);
+}
+
+static void PrintStatistics(const ValidationPath* path, const PathStatistics* p)
+{
+    int i, decade;
+
+    printf("%-10s bound %5.2lf s | compared %llu, ill-conditioned %llu, NaN mismatches %llu, failures %llu\n",
+           path->name, path->boundSeconds,
+           (unsigned long long) p->compared, (unsigned long long) p->illConditioned,
+           (unsigned long long) p->nanMismatches, (unsigned long long) p->failures);
+    printf("           p50 <= %.3g s, p90 <= %.3g s, p99 <= %.3g s, p99.9 <= %.3g s, max %.3g s",
+           Percentile(p, 0.5), Percentile(p, 0.9), Percentile(p, 0.99), Percentile(p, 0.999),
+           p->maxError);
+    if (p->illConditioned)
+    {
+        printf(", ill-conditioned max %.3g s", p->maxIllConditioned);
+    }
+    printf("\n           exact %llu", (unsigned long long) p->histogram[0]);
+    for (decade = 0; decade < HISTOGRAM_DECADES; ++decade)
+    {
+        uint64_t n = 0;
+        for (i = 0; i < HISTOGRAM_BINS_PER_DECADE; ++i)
+        {
+            int bin = 1 + decade * HISTOGRAM_BINS_PER_DECADE + i;
+            if (bin < HISTOGRAM_BINS)
+            {
+                n += p->histogram[bin];
+            }
+        }
+        if (n)
+        {
+            printf(" | <1e%d s: %llu", HISTOGRAM_MIN_LOG10 + decade + 1, (unsigned long long) n);
+        }
+    }
+    printf("\n");
+    for (i = 0; i < WORST_CASES && p->worst[i].error > 0.0; ++i)
+    {
+        const WorstCase* w = p->worst + i;
+        printf("           worst: %.3g s at jd %.1lf lat %+.6lf angle %.3lf %s (ref %.4lf min, got %.4lf min)\n",
+               w->error, w->sample.jd, w->sample.latitude, w->sample.angle,
+               w->sample.rise ? "rise" : "set", w->reference, w->value);
+    }
+}
+
+/*
+ Golden tables use the layout printed by solar_times: a date line
+ "year month day", then one row per latitude with the six events
+ (nautical, civil twilight begin, sunrise, sunset, civil, nautical
+ twilight end) as "hh mm"; "N/A", "////" or "----" mark no event.
+ Lines starting with '#' are comments.
+*/
+#define MAX_GOLDEN_LATITUDES (64)
+#define GOLDEN_EVENTS (6)
+
+typedef struct HourMinute
+{
+    int hour;   /* -1: no event */
+    int minute;
+} HourMinute;
+
+/* one almanac page */
+typedef struct SunPositionTest
+{
+    int y;
+    int m;
+    double dfrac;
+
+    int numLatitudes;
+    double latitude[MAX_GOLDEN_LATITUDES];
+    HourMinute nauticalRise[MAX_GOLDEN_LATITUDES];
+    HourMinute civilRise[MAX_GOLDEN_LATITUDES];
+    HourMinute sunRise[MAX_GOLDEN_LATITUDES];
+    HourMinute sunSet[MAX_GOLDEN_LATITUDES];
+    HourMinute civilSet[MAX_GOLDEN_LATITUDES];
+    HourMinute nauticalSet[MAX_GOLDEN_LATITUDES];
+
+} SunPositionTest;
+
+static const char* ParseHourMinute(const char* p, HourMinute* hm)
+{
+    int n = 0;
+
+    while (*p == ' ' || *p == '|')
+    {
+        ++p;
+    }
+    if (2 == sscanf(p, "%d %d%n", &hm->hour, &hm->minute, &n) && hm->hour >= 0)
+    {
+        return p + n;
+    }
+    hm->hour = -1;
+    hm->minute = 0;
+    while (*p && *p != '|')
+    {
+        ++p;
+    }
+    return p;
+}
+
+/* toleranceMinutes applies to the reference; each path is also allowed
+   its bound to the reference */
+static int CompareGolden(const SunPositionTest* t, double toleranceMinutes)
+{
+    const double angles[GOLDEN_EVENTS] =
+    {
+        kNauticalTwilight, kCivilTwilight, kRiseOrSet,
+        kRiseOrSet, kCivilTwilight, kNauticalTwilight
+    };
+    const HourMinute* events[GOLDEN_EVENTS] =
+    {
+        t->nauticalRise, t->civilRise, t->sunRise,
+        t->sunSet, t->civilSet, t->nauticalSet
+    };
+    double jd = JulianDayEx(t->y, t->m, t->dfrac);
+    int failures = 0;
+    int i, e, k;
+
+    for (k = -1; k < NUM_PATHS; ++k)
+    {
+        if (k >= 0 && kPaths[k].kind != kValidateEventTime)
+        {
+            continue;
+        }
+        double tolerance = toleranceMinutes + ((k < 0) ? 0.0 : kPaths[k].boundSeconds / 60.0);
+
+        for (e = 0; e < GOLDEN_EVENTS; ++e)
+        {
+            void* cache = NULL;
+
+            for (i = 0; i < t->numLatitudes; ++i)
+            {
+                const HourMinute* hm = events[e] + i;
+                ValidationSample s = { jd, t->latitude[i], angles[e], e < 3 };
+                double value = (k < 0) ? ReferenceEventTime(&s) : kPaths[k].function(&s, &cache);
+                /* as formatted by solar_times */
+                int absent = isnan(value) || value < 0.0;
+                int match = absent ? (hm->hour < 0) :
+                    (hm->hour >= 0 &&
+                     fabs(value - (hm->hour * 60 + hm->minute)) <= tolerance);
+
+                if (!match)
+                {
+                    printf("golden %d-%02d-%04.1lf lat %+.1lf event %d: %s got %.2lf min, expected %02d %02d\n",
+                           t->y, t->m, t->dfrac, t->latitude[i], e,
+                           (k < 0) ? "reference" : kPaths[k].name, value,
+                           hm->hour, hm->minute);
+                    ++failures;
+                }
+            }
+            if (k >= 0 && kPaths[k].release)
+            {
+                kPaths[k].release(cache);
+            }
+        }
+    }
+    return failures;
+}
+
+/* returns the number of mismatches, or -1 if the file cannot be read */
+static int ValidateGoldenFile(const char* path, double toleranceMinutes)
+{
+    FILE* f = fopen(path, "r");
+    SunPositionTest* t = calloc(1, sizeof(SunPositionTest));
+    char line[256];
+    int failures = 0, pages = 0, rows = 0;
+
+    if (NULL == f || NULL == t)
+    {
+        if (f)
+        {
+            fclose(f);
+        }
+        free(t);
+        return -1;
+    }
+    t->y = 0;
+    while (fgets(line, sizeof(line), f))
+    {
+        int y, m;
+        double d;
+        const char* p = line;
+
+        while (*p == ' ' || *p == '\t')
+        {
+            ++p;
+        }
+        if (*p == '#' || *p == '\n' || *p == '\0')
+        {
+            continue;
+        }
+        if (*p == '|')
+        {
+            int i = t->numLatitudes;
+            if (0 == t->y || i == MAX_GOLDEN_LATITUDES ||
+                1 != sscanf(p + 1, "%lf", &t->latitude[i]))
+            {
+                continue;
+            }
+            p = strchr(p + 1, '|');
+            if (NULL == p)
+            {
+                printf("golden %s: malformed row: %s", path, line);
+                ++failures;
+                continue;
+            }
+            p = ParseHourMinute(p, &t->nauticalRise[i]);
+            p = ParseHourMinute(p, &t->civilRise[i]);
+            p = ParseHourMinute(p, &t->sunRise[i]);
+            p = ParseHourMinute(p, &t->sunSet[i]);
+            p = ParseHourMinute(p, &t->civilSet[i]);
+            ParseHourMinute(p, &t->nauticalSet[i]);
+            ++t->numLatitudes;
+            ++rows;
+        }
+        else if (3 == sscanf(p, "%d %d %lf", &y, &m, &d))
+        {
+            if (t->numLatitudes)
+            {
+                failures += CompareGolden(t, toleranceMinutes);
+            }
+            memset(t, 0, sizeof(SunPositionTest));
+            t->y = y;
+            t->m = m;
+            t->dfrac = d;
+            ++pages;
+        }
+    }
+    if (t->numLatitudes)
+    {
+        failures += CompareGolden(t, toleranceMinutes);
+    }
+    fclose(f);
+    free(t);
+
+    printf("golden %s: %d dates, %d rows, %d mismatches\n", path, pages, rows, failures);
+    return failures;
+}
+
+int main(int argc, char* argv[])
+{
+    uint64_t samples = 100000;
+    uint64_t seed = 20160101;
+    long numThreads = sysconf(_SC_NPROCESSORS_ONLN);
+    /* minutes: rounding of the tabulated times, for files produced from
+       the reference; pass -e for pages from another source */
+    double goldenTolerance = 0.5 + 1.0e-6;
+    int retVal = 0;
+    int i, k;
+
+    for (i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "-n") && i + 1 < argc)
+        {
+            samples = strtoull(argv[++i], NULL, 10);
+        }
+        else if (0 == strcmp(argv[i], "-t") && i + 1 < argc)
+        {
+            numThreads = strtol(argv[++i], NULL, 10);
+        }
+        else if (0 == strcmp(argv[i], "-s") && i + 1 < argc)
+        {
+            seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (0 == strcmp(argv[i], "-e") && i + 1 < argc)
+        {
+            goldenTolerance = strtod(argv[++i], NULL);
+        }
+        else if (0 == strcmp(argv[i], "-g") && i + 1 < argc)
+        {
+            int failures = ValidateGoldenFile(argv[++i], goldenTolerance);
+            if (failures < 0)
+            {
+                printf("cannot read golden file %s\n", argv[i]);
+                failures = 1;
+            }
+            retVal += failures;
+        }
+        else
+        {
+            printf("usage: %s [-n samples] [-t threads] [-s seed] [-e minutes] [-g golden]...\n", argv[0]);
+            return 1;
+        }
+    }
+    if (numThreads < 1)
+    {
+        numThreads = 1;
+    }
+
+    uint64_t numEdgeCases;
+    ValidationSample* edgeCases = EdgeCases(&numEdgeCases);
+    ValidationThread* threads = calloc(numThreads, sizeof(ValidationThread));
+    if (NULL == edgeCases || NULL == threads)
+    {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    for (i = 0; i < numThreads; ++i)
+    {
+        ValidationThread* t = threads + i;
+        t->seed = seed;
+        t->begin = samples * i / numThreads;
+        t->end = samples * (i + 1) / numThreads;
+        if (0 == i)
+        {
+            t->edgeCases = edgeCases;
+            t->numEdgeCases = numEdgeCases;
+        }
+        if (0 != pthread_create(&t->thread, NULL, ValidationWorker, t))
+        {
+            printf("cannot create thread %d\n", i);
+            return 1;
+        }
+    }
+
+    PathStatistics total[NUM_PATHS];
+    memset(total, 0, sizeof(total));
+    for (i = 0; i < numThreads; ++i)
+    {
+        pthread_join(threads[i].thread, NULL);
+        for (k = 0; k < NUM_PATHS; ++k)
+        {
+            MergeStatistics(total + k, threads[i].statistics + k);
+        }
+    }
+
+    printf("%llu random samples (seed %llu) and %llu edge cases on %ld threads\n",
+           (unsigned long long) samples, (unsigned long long) seed,
+           (unsigned long long) numEdgeCases, numThreads);
+    for (k = 0; k < NUM_PATHS; ++k)
+    {
+        PrintStatistics(kPaths + k, total + k);
+        retVal += (int) (total[k].failures > 0);
+    }
+
+    free(threads);
+    free(edgeCases);
+    return retVal;
+}